@@ -0,0 +1,246 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+// Correctness tests and throughput benchmark for EnemyDecisionCore, with no engine in the process.
+// Built as the RashepurDecisionCoreTests program target, or directly with any C++17 compiler:
+//   g++ -std=c++17 -O2 -Wall -Wextra -I Source/Rashepur/Public Source/Programs/RashepurDecisionCoreTests/Private/RashepurDecisionCoreTests.cpp
+// Exits non zero when a test fails. Pass --bench [Decisions] to also time Decide.
+
+#include "AI/EnemyDecisionCore.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace EnemyDecisionCore;
+
+namespace
+{
+	int NumChecks = 0;
+	int NumFailures = 0;
+
+	void Check(bool bPassed, const char* What, int State, int Action, int EnemyFlags)
+	{
+		++NumChecks;
+		if (!bPassed)
+		{
+			++NumFailures;
+			if (NumFailures <= 20)
+				std::printf("FAILED %s (state %d, action %d, flags 0x%02x)\n", What, State, Action, EnemyFlags);
+		}
+	}
+
+	constexpr int NumStates = (int)EState::NoState + 1;
+	constexpr int NumActions = (int)EAction::Attacking + 1;
+
+	/** State bits DecideCombat packs above the flags, built here the long way */
+	uint32_t StateMask(EState State, EAction Action)
+	{
+		uint32_t Mask = 0;
+		if (Action == EAction::Attacking) Mask |= Masks::Attacking;
+		if (State == EState::Chasing) Mask |= Masks::Chasing;
+		if (State == EState::Searching) Mask |= Masks::Searching;
+		if (State == EState::Engaged) Mask |= Masks::Engaged;
+		if (State == EState::Patrolling) Mask |= Masks::Patrolling;
+		return Mask;
+	}
+
+	/**
+	 * AEnemy's CheckCombatTarget and CheckPatrolTarget as they read before the rules moved into EnemyDecisionCore,
+	 * one bool per predicate term, so the mask tables are checked against the original conditions
+	 */
+	namespace Reference
+	{
+		bool InCombatRadius(uint8_t EnemyFlags) { return (EnemyFlags & Flags::InCombatRadius) != 0; }
+		bool InAttackRadius(uint8_t EnemyFlags) { return (EnemyFlags & Flags::InAttackRadius) != 0; }
+		bool CanSeeTarget(uint8_t EnemyFlags) { return (EnemyFlags & Flags::CanSeeTarget) != 0; }
+
+		bool CanChase(EState State, EAction, uint8_t EnemyFlags)
+		{
+			return InCombatRadius(EnemyFlags) &&
+				!InAttackRadius(EnemyFlags) &&
+				State != EState::Chasing &&
+				State != EState::Searching &&
+				CanSeeTarget(EnemyFlags);
+		}
+
+		bool CanSearch(EState State, EAction Action, uint8_t EnemyFlags)
+		{
+			return InCombatRadius(EnemyFlags) &&
+				Action != EAction::Attacking &&
+				State != EState::Searching &&
+				!CanSeeTarget(EnemyFlags);
+		}
+
+		bool CanEngage(EState State, EAction Action, uint8_t EnemyFlags)
+		{
+			return InAttackRadius(EnemyFlags) &&
+				State != EState::Engaged &&
+				Action != EAction::Attacking &&
+				CanSeeTarget(EnemyFlags) &&
+				State != EState::Searching;
+		}
+
+		EDecision Decide(EState State, EAction Action, uint8_t EnemyFlags)
+		{
+			if (!(EnemyFlags & Flags::DecisionDue)) return EDecision::EAD_None;
+			if (State == EState::Dead || State == EState::Staggered) return EDecision::EAD_None;
+
+			if (State > EState::Patrolling)
+			{
+				if (!InCombatRadius(EnemyFlags)) return EDecision::EAD_LoseInterest;
+				if (CanChase(State, Action, EnemyFlags)) return EDecision::EAD_Chase;
+				if (CanSearch(State, Action, EnemyFlags)) return EDecision::EAD_Search;
+				if (CanEngage(State, Action, EnemyFlags)) return EDecision::EAD_Engage;
+				if ((EnemyFlags & Flags::CombatTargetDead) && State != EState::Patrolling) return EDecision::EAD_CombatTargetDead;
+				return EDecision::EAD_None;
+			}
+			return (EnemyFlags & Flags::InPatrolRadius) ? EDecision::EAD_ReachedPatrolTarget : EDecision::EAD_None;
+		}
+	}
+
+	/** Every state, action and flag byte: each predicate and the full decision against the reference */
+	void TestPredicatesExhaustive()
+	{
+		for (int State = 0; State < NumStates; ++State)
+		for (int Action = 0; Action < NumActions; ++Action)
+		for (int EnemyFlags = 0; EnemyFlags < 256; ++EnemyFlags)
+		{
+			const EState S = (EState)State;
+			const EAction A = (EAction)Action;
+			const uint8_t F = (uint8_t)EnemyFlags;
+			const uint32_t Mask = F | StateMask(S, A);
+
+			// the mask predicates only run once the target is inside CombatRadius
+			if (Reference::InCombatRadius(F))
+			{
+				Check(Masks::CanChase.Test(Mask) == Reference::CanChase(S, A, F), "CanChase", State, Action, EnemyFlags);
+				Check(Masks::CanSearch.Test(Mask) == Reference::CanSearch(S, A, F), "CanSearch", State, Action, EnemyFlags);
+				Check(Masks::CanEngage.Test(Mask) == Reference::CanEngage(S, A, F), "CanEngage", State, Action, EnemyFlags);
+			}
+			Check(Decide(S, A, F) == Reference::Decide(S, A, F), "Decide matches reference", State, Action, EnemyFlags);
+		}
+	}
+
+	void TestLoseInterest()
+	{
+		// every combat state loses interest outside CombatRadius, whatever else is set
+		for (int State = (int)EState::Chasing; State < NumStates; ++State)
+		for (int Action = 0; Action < NumActions; ++Action)
+		for (int EnemyFlags = 0; EnemyFlags < 256; ++EnemyFlags)
+		{
+			const uint8_t F = (uint8_t)((EnemyFlags | Flags::DecisionDue) & ~Flags::InCombatRadius);
+			Check(Decide((EState)State, (EAction)Action, F) == EDecision::EAD_LoseInterest, "LoseInterest outside CombatRadius", State, Action, F);
+		}
+
+		// a combat target that left the combat band is lost even while it was in attack range last frame
+		const uint8_t NoCombatTarget = RangeBits(Flags::DecisionDue, 0.f, 1e9f, 100.f, 25.f, 1.f) | Flags::DecisionDue | Flags::CanSeeTarget;
+		Check(Decide(EState::Engaged, EAction::Attacking, NoCombatTarget) == EDecision::EAD_LoseInterest, "LoseInterest without a combat target", (int)EState::Engaged, (int)EAction::Attacking, NoCombatTarget);
+
+		// patrolling, dead and staggered enemies never lose interest, they have none
+		for (int EnemyFlags = 0; EnemyFlags < 256; ++EnemyFlags)
+		{
+			const uint8_t F = (uint8_t)(EnemyFlags | Flags::DecisionDue);
+			Check(Decide(EState::Patrolling, EAction::Unoccupied, F) != EDecision::EAD_LoseInterest, "Patrolling never loses interest", (int)EState::Patrolling, 0, F);
+			Check(Decide(EState::Dead, EAction::Unoccupied, F) == EDecision::EAD_None, "Dead never decides", (int)EState::Dead, 0, F);
+			Check(Decide(EState::Staggered, EAction::HitReaction, F) == EDecision::EAD_None, "Staggered never decides", (int)EState::Staggered, 1, F);
+		}
+
+		// nothing is decided between decision intervals
+		for (int EnemyFlags = 0; EnemyFlags < 128; ++EnemyFlags)
+			Check(Decide(EState::Chasing, EAction::Unoccupied, (uint8_t)EnemyFlags) == EDecision::EAD_None, "No decision unless due", (int)EState::Chasing, 0, EnemyFlags);
+	}
+
+	void TestRangeBits()
+	{
+		const uint8_t Both = Flags::HasCombatTarget | Flags::HasPatrolTarget;
+		Check(RangeBits(Both, 100.f, 0.f, 100.f, 25.f, 1.f) == (Flags::InCombatRadius | Flags::InPatrolRadius), "CombatRadius is inclusive", 0, 0, Both);
+		Check(RangeBits(Both, 25.f, 2.f, 100.f, 25.f, 1.f) == (Flags::InCombatRadius | Flags::InAttackRadius), "AttackRadius is inclusive", 0, 0, Both);
+		Check(RangeBits(Both, 101.f, 2.f, 100.f, 25.f, 1.f) == 0, "Outside every band", 0, 0, Both);
+		Check(RangeBits(Flags::HasCombatTarget, 0.f, 0.f, 100.f, 25.f, 1.f) == (Flags::InCombatRadius | Flags::InAttackRadius), "Patrol band needs a patrol target", 0, 0, Flags::HasCombatTarget);
+		Check(RangeBits(Flags::HasPatrolTarget, 0.f, 0.f, 100.f, 25.f, 1.f) == Flags::InPatrolRadius, "Combat bands need a combat target", 0, 0, Flags::HasPatrolTarget);
+		Check(RangeBits(0, 0.f, 0.f, 100.f, 25.f, 1.f) == 0, "No targets, no bands", 0, 0, 0);
+	}
+
+	void TestPatrolCandidates()
+	{
+		for (int32_t NumPoints = 1; NumPoints <= 16; ++NumPoints)
+		for (int32_t CurrentIndex = -1; CurrentIndex < NumPoints; ++CurrentIndex)
+		{
+			// the candidates cover every point exactly once, except the one we are standing at
+			const int32_t NumCandidates = NumPatrolCandidates(NumPoints, CurrentIndex);
+			Check(NumCandidates == (CurrentIndex < 0 ? NumPoints : NumPoints - 1), "NumPatrolCandidates", NumPoints, CurrentIndex, 0);
+
+			std::vector<int> Picked(NumPoints, 0);
+			for (int32_t Candidate = 0; Candidate < NumCandidates; ++Candidate)
+			{
+				const int32_t PointIndex = PatrolIndexFromCandidate(Candidate, CurrentIndex);
+				const bool bInRange = PointIndex >= 0 && PointIndex < NumPoints;
+				Check(bInRange, "Patrol point in range", NumPoints, CurrentIndex, Candidate);
+				if (bInRange)
+					++Picked[PointIndex];
+			}
+			for (int32_t PointIndex = 0; PointIndex < NumPoints; ++PointIndex)
+				Check(Picked[PointIndex] == (PointIndex == CurrentIndex ? 0 : 1), "Every other patrol point is a candidate once", NumPoints, CurrentIndex, PointIndex);
+		}
+	}
+
+	void Bench(int NumDecisions)
+	{
+		// random inputs up front so the timed loop only measures Decide
+		std::mt19937 Random((unsigned)NumDecisions);
+		std::vector<uint8_t> States(NumDecisions), Actions(NumDecisions), EnemyFlags(NumDecisions);
+		for (int Index = 0; Index < NumDecisions; ++Index)
+		{
+			States[Index] = (uint8_t)(Random() % NumStates);
+			Actions[Index] = (uint8_t)(Random() % NumActions);
+			EnemyFlags[Index] = (uint8_t)(Random() | Flags::DecisionDue);
+		}
+
+		unsigned DecisionCounts[8] = {};
+		const auto Start = std::chrono::steady_clock::now();
+		for (int Index = 0; Index < NumDecisions; ++Index)
+		{
+			const EDecision Decision = Decide((EState)States[Index], (EAction)Actions[Index], EnemyFlags[Index]);
+			++DecisionCounts[(uint8_t)Decision & 7];
+		}
+		const double Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+
+		std::printf("DecisionCore %9d decisions: %8.2f ns/decision, %7.1f M decisions/s (chase %u, search %u, engage %u)\n",
+			NumDecisions,
+			Seconds * 1e9 / NumDecisions,
+			NumDecisions / (Seconds > 0.0 ? Seconds : 1e-9) / 1e6,
+			DecisionCounts[(uint8_t)EDecision::EAD_Chase],
+			DecisionCounts[(uint8_t)EDecision::EAD_Search],
+			DecisionCounts[(uint8_t)EDecision::EAD_Engage]);
+	}
+}
+
+int main(int ArgC, char* ArgV[])
+{
+	TestPredicatesExhaustive();
+	TestLoseInterest();
+	TestRangeBits();
+	TestPatrolCandidates();
+	std::printf("EnemyDecisionCore: %d checks, %d failed\n", NumChecks, NumFailures);
+
+	for (int Arg = 1; Arg < ArgC; ++Arg)
+	{
+		if (std::strcmp(ArgV[Arg], "--bench") == 0)
+		{
+			const int NumDecisions = Arg + 1 < ArgC ? std::atoi(ArgV[Arg + 1]) : 0;
+			if (NumDecisions > 0)
+			{
+				Bench(NumDecisions);
+			}
+			else
+			{
+				Bench(1000000);
+				Bench(10000000);
+			}
+		}
+	}
+	return NumFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,15 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+using System.IO;
+using UnrealBuildTool;
+
+public class RashepurDecisionCoreTests : ModuleRules
+{
+	public RashepurDecisionCoreTests(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = PCHUsageMode.NoPCHs;
+		bUseUnity = false;
+
+		PrivateIncludePaths.Add(Path.Combine(ModuleDirectory, "..", "..", "Rashepur", "Public"));
+	}
+}
@@ -3,8 +3,12 @@
 
 #include "HeroAnimInstance.h"
 #include "HeroCharacter.h"
+#include "Rashepur.h"
 #include "GameFramework/CharacterMovementComponent.h"
-#include "Kismet/KismetMathLibrary.h"
+
+DECLARE_CYCLE_STAT(TEXT("Hero Anim Game Thread Update"), STAT_HeroAnimGameThreadUpdate, STATGROUP_Rashepur);
+DECLARE_CYCLE_STAT(TEXT("Hero Anim Thread Safe Update"), STAT_HeroAnimThreadSafeUpdate, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Hero Anim Updates Off Game Thread"), STAT_HeroAnimUpdatesOffGameThread, STATGROUP_Rashepur);
 
 void UHeroAnimInstance::NativeInitializeAnimation()
 {
@@ -17,14 +21,29 @@ void UHeroAnimInstance::NativeInitializeAnimation()
     }
 }
 
+void UHeroAnimInstance::NativeBeginPlay()
+{
+    Super::NativeBeginPlay();
+    CharacterAnim::WarnIfGameThreadOnly(this);
+}
+
 void UHeroAnimInstance::NativeUpdateAnimation(float DeltaTime)
 {
+    SCOPE_CYCLE_COUNTER(STAT_HeroAnimGameThreadUpdate);
     Super::NativeUpdateAnimation(DeltaTime);
-    if (HeroCharacterMovement) 
+    if (HeroCharacter) 
     {
-        GroundSpeed = UKismetMathLibrary::VSizeXY(HeroCharacterMovement->Velocity);
-        IsFalling = HeroCharacterMovement->IsFalling();
-        CharacterState = HeroCharacter->GetCharacterState();
+        HeroCharacter->PublishAnimSnapshot(Snapshot);
     }
+}
 
+void UHeroAnimInstance::NativeThreadSafeUpdateAnimation(float DeltaTime)
+{
+    SCOPE_CYCLE_COUNTER(STAT_HeroAnimThreadSafeUpdate);
+    Super::NativeThreadSafeUpdateAnimation(DeltaTime);
+    if (!IsInGameThread())
+        INC_DWORD_STAT(STAT_HeroAnimUpdatesOffGameThread);
+    GroundSpeed = Snapshot.GroundSpeed;
+    IsFalling = Snapshot.bIsFalling;
+    CharacterState = Snapshot.CharacterState;
 }
@@ -5,15 +5,16 @@
 #include "CoreMinimal.h"
 #include "Animation/AnimInstance.h"
 #include "CharacterStates.h"
+#include "Characters/BaseCharacter.h"
 
 #include "HeroAnimInstance.generated.h"
 
-/**
- * 
- */
 class AHeroCharacter;
 class UCharacterMovementComponent;
 
+/**
+ * Same split as UEnemyAnimInstance: the hero's snapshot is copied on the game thread, the graph variables are set on the worker
+ */
 UCLASS()
 class RASHEPUR_API UHeroAnimInstance : public UAnimInstance
 {
@@ -21,7 +22,9 @@ class RASHEPUR_API UHeroAnimInstance : public UAnimInstance
 
 public:
 	virtual void NativeInitializeAnimation() override;
-	virtual void NativeUpdateAnimation(float DeltaTime);
+	virtual void NativeBeginPlay() override;
+	virtual void NativeUpdateAnimation(float DeltaTime) override;
+	virtual void NativeThreadSafeUpdateAnimation(float DeltaTime) override;
 
 	UPROPERTY(BlueprintReadOnly, Category = "AnimInstance")
 	AHeroCharacter* HeroCharacter;
@@ -38,4 +41,6 @@ public:
 	UPROPERTY(BlueprintReadOnly, Category = "Movement | Character State" )
 	ECharacterState CharacterState;
 
+private:
+	FCharacterAnimSnapshot Snapshot;
 };
@@ -2,6 +2,8 @@
 
 
 #include "HeroCharacter.h"
+#include "Components/CombatStatusComponent.h"
+#include "Characters/MontageSectionRegistry.h"
 #include "Rashepur/Weapons/WeaponTypes.h"
 #include "EnhancedInputSubsystems.h"
 #include "EnhancedInputComponent.h"
@@ -17,6 +19,8 @@
 #include "Perception/PawnSensingComponent.h"
 #include "HUD/RashepurHUD.h"
 #include "HUD/HUDOverlay.h"
+#include "Spatial/SpatialHashSubsystem.h"
+#include "Characters/CharacterStateTransitions.h"
 
 
 // Sets default values
@@ -24,6 +28,7 @@ AHeroCharacter::AHeroCharacter()
 {
  	// Set this character to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
+	CombatStatus->SetFaction(ECombatFaction::ECF_Hero);
 
 	bUseControllerRotationPitch = false;
 	bUseControllerRotationRoll = false;
@@ -69,6 +74,8 @@ void AHeroCharacter::BeginPlay()
 		}
 	}
 	Tags.Add(FName("Hero")); 
+	if (USpatialHashSubsystem* SpatialHash = GetWorld()->GetSubsystem<USpatialHashSubsystem>())
+		SpatialHash->Register(this, ESpatialCategory::Hero);
 }
 
 void AHeroCharacter::InitializeOverlay(APlayerController* PlayerController)
@@ -133,6 +140,8 @@ void AHeroCharacter::EKeyPressed(const FInputActionValue &Value)
 			EquippedWeapon->DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);	
 			EquippedWeapon->SetItemState(EItemState::EIS_Hovering);
 			EquippedWeapon->SetActorRotation(FRotator(0.f, 0.f, 0.f));
+			if (USpatialHashSubsystem* SpatialHash = GetWorld()->GetSubsystem<USpatialHashSubsystem>())
+				SpatialHash->Register(EquippedWeapon, ESpatialCategory::Pickup);
 			EquippedWeapon=nullptr;
 		}
         FName WeaponSocket = GetWeaponSocket(OverlappingWeapon);
@@ -145,12 +154,12 @@ void AHeroCharacter::EKeyPressed(const FInputActionValue &Value)
 	{
 		if (CanUnequip()) 
 		{ 
-			PlayEActionMontage("Unequip");
+			PlayEActionMontage(EMontageSection::Unequip);
 			CharacterState = ECharacterState::ECS_Unequipped;			
 		} 
 		else if (CanEquip()) 
 		{
-			PlayEActionMontage("Equip");
+			PlayEActionMontage(EMontageSection::Equip);
 			SetCharacterStateByWeaponType();
 		}
 	}
@@ -202,22 +211,30 @@ bool AHeroCharacter::CanUnequip() const
 			&& CharacterState != ECharacterState::ECS_Unequipped;
 }
 
-void AHeroCharacter::PlayEActionMontage(const FName& SectionName)
+void AHeroCharacter::PlayEActionMontage(EMontageSection Section)
 {
 	if (EActionMontage) 
 	{
-		ActionState = EActionState::EAS_Occupied;
-		if (bDebugStates)
-			UE_LOG(LogTemp, Warning, TEXT("ActionState set to EAS_Occupied HeroCharacter (PlayEActionMontage)"));
-		PlayMontageSection(EActionMontage, SectionName);
+		SetActionState(EActionState::EAS_Occupied);
+		RASHEPUR_STATE_LOG(bDebugStates, Warning, TEXT("ActionState set to EAS_Occupied HeroCharacter (PlayEActionMontage)"));
+		PlayMontageSection(EActionMontage, GetMontageSection(EActionMontage, Section));
+	}
+}
+
+void AHeroCharacter::RegisterMontageSections()
+{
+	Super::RegisterMontageSections();
+	if (UMontageSectionRegistry* Registry = UMontageSectionRegistry::Find(GetWorld()))
+	{
+		if (EActionMontage)
+			Registry->Register(EActionMontage);
 	}
 }
 
 void AHeroCharacter::OnActionEnded(UAnimMontage *Montage, bool bInterrupted)
 {
-	ActionState = EActionState::EAS_Unoccupied;
-	if (bDebugStates)
-		UE_LOG(LogTemp, Warning, TEXT("ActionState set to EAS_Unoccupied HeroCharacter (OnActionEnded)"));
+	SetActionState(EActionState::EAS_Unoccupied);
+	RASHEPUR_STATE_LOG(bDebugStates, Warning, TEXT("ActionState set to EAS_Unoccupied HeroCharacter (OnActionEnded)"));
 }
 
 // Called to bind functionality to input
@@ -262,12 +279,12 @@ void AHeroCharacter::Jump()
 		Super::Jump();
 }
 
-void AHeroCharacter::SetOverlappingItem(AItem* Item)
+void AHeroCharacter::SetOverlappingItem_Implementation(AItem* Item)
 {
 	OverlappingItem = Item;
 }
 
-void AHeroCharacter::AddSouls(ASoul* Soul)
+void AHeroCharacter::AddSouls_Implementation(ASoul* Soul)
 {
 	UE_LOG(LogTemp, Warning, TEXT("Add Souls: "));
 }
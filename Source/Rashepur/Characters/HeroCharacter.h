@@ -45,8 +45,8 @@ public:
 	/** </ACharacter> */
 
 	/** <IPickupInterface> */
-	virtual void SetOverlappingItem(AItem* Item) override;
-	virtual void AddSouls(ASoul* Soul) override;
+	virtual void SetOverlappingItem_Implementation(AItem* Item) override;
+	virtual void AddSouls_Implementation(ASoul* Soul) override;
 	/** </IPickupInterface> */
 
 protected:
@@ -55,6 +55,10 @@ protected:
 	virtual void Tick(float DeltaTime) override;
 	/** </AActor> */
 
+	/** <ABaseCharacter> */
+	virtual void RegisterMontageSections() override;
+	/** </ABaseCharacter> */
+
 	/** 
 	 * Callback to inputs
 	*/
@@ -83,7 +87,7 @@ protected:
     /**
 	 * Animation Montages
 	*/
-	void PlayEActionMontage(const FName& SectionName);
+	void PlayEActionMontage(EMontageSection Section);
 	void OnActionEnded(UAnimMontage* Montage, bool bInterrupted);
 	
 private: 
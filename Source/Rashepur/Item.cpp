@@ -3,6 +3,7 @@
 #include "Components/SphereComponent.h"
 #include "Interfaces/PickupInterface.h"
 #include "NiagaraComponent.h"
+#include "Spatial/SpatialHashSubsystem.h"
 
 AItem::AItem()
 {
@@ -30,25 +31,19 @@ void AItem::BeginPlay()
 
 	Sphere->OnComponentBeginOverlap.AddDynamic(this, &AItem::OnSphereOverlap);
 	Sphere->OnComponentEndOverlap.AddDynamic(this, &AItem::OnSphereOverlapEnd);
+	if (USpatialHashSubsystem* SpatialHash = GetWorld()->GetSubsystem<USpatialHashSubsystem>())
+		SpatialHash->Register(this, ESpatialCategory::Pickup);
 
 }
 
 void AItem::OnSphereOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
 {
-	IPickupInterface* PickupInterface = Cast<IPickupInterface>(OtherActor);
-	if (PickupInterface)
-	{
-		PickupInterface->SetOverlappingItem(this);
-	}
+	IPickupInterface::DispatchSetOverlappingItem(OtherActor, this);
 }
 
 void AItem::OnSphereOverlapEnd(UPrimitiveComponent *OverlappedComponent, AActor *OtherActor, UPrimitiveComponent *OtherComp, int32 OtherBodyIndex)
 {
-	IPickupInterface* PickupInterface = Cast<IPickupInterface>(OtherActor);
-	if (PickupInterface)
-	{
-		PickupInterface->SetOverlappingItem(nullptr);
-	}
+	IPickupInterface::DispatchSetOverlappingItem(OtherActor, nullptr);
 }
 
 void AItem::Tick(float DeltaTime)
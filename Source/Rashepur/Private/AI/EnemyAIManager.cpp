@@ -0,0 +1,860 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AI/EnemyAIManager.h"
+#include "Rashepur.h"
+#include "Enemy/Enemy.h"
+#include "Components/CombatStatusComponent.h"
+#include "AI/EnemyRangeKernel.h"
+#include "AI/EnemyAnimSharingSubsystem.h"
+#include "Spatial/SpatialHashSubsystem.h"
+#include "Perception/PawnSensingComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "AI/EnemyPoolSubsystem.h"
+#include "Components/AttributeComponent.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/DamageType.h"
+#include "Kismet/GameplayStatics.h"
+#include "AIController.h"
+#include "EngineUtils.h"
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+
+// the decision core has its own copies of the state enums, they are converted by value
+static_assert((uint8)EEnemyState::EES_Staggered == (uint8)EnemyDecisionCore::EState::Staggered &&
+	(uint8)EEnemyState::EES_Dead == (uint8)EnemyDecisionCore::EState::Dead &&
+	(uint8)EEnemyState::EES_Patrolling == (uint8)EnemyDecisionCore::EState::Patrolling &&
+	(uint8)EEnemyState::EES_Chasing == (uint8)EnemyDecisionCore::EState::Chasing &&
+	(uint8)EEnemyState::EES_Searching == (uint8)EnemyDecisionCore::EState::Searching &&
+	(uint8)EEnemyState::EES_Engaged == (uint8)EnemyDecisionCore::EState::Engaged &&
+	(uint8)EEnemyState::EES_NoState == (uint8)EnemyDecisionCore::EState::NoState,
+	"EnemyDecisionCore::EState is out of sync with EEnemyState");
+static_assert((uint8)EActionState::EAS_Unoccupied == (uint8)EnemyDecisionCore::EAction::Unoccupied &&
+	(uint8)EActionState::EAS_HitReaction == (uint8)EnemyDecisionCore::EAction::HitReaction &&
+	(uint8)EActionState::EAS_Occupied == (uint8)EnemyDecisionCore::EAction::Occupied &&
+	(uint8)EActionState::EAS_PerformingAction == (uint8)EnemyDecisionCore::EAction::PerformingAction &&
+	(uint8)EActionState::EAS_Attacking == (uint8)EnemyDecisionCore::EAction::Attacking,
+	"EnemyDecisionCore::EAction is out of sync with EActionState");
+
+static TAutoConsoleVariable<bool> CVarEnemyAIParallelDecide(
+	TEXT("Rashepur.AI.ParallelDecide"),
+	true,
+	TEXT("Runs the enemy range and decision passes over chunks on worker threads"));
+
+static TAutoConsoleVariable<int32> CVarEnemyAIParallelChunkSize(
+	TEXT("Rashepur.AI.ParallelChunkSize"),
+	256,
+	TEXT("Enemies per parallel decide task, rounded up to a multiple of 4 for the range kernel"));
+
+#if !UE_BUILD_SHIPPING
+static TAutoConsoleVariable<bool> CVarEnemyAIVerifyParallelDecide(
+	TEXT("Rashepur.AI.VerifyParallelDecide"),
+	false,
+	TEXT("Re-runs the range and decision passes serially after the parallel ones and reports any enemy whose flags or decision differ"));
+#endif
+
+static FORCEINLINE EnemyDecisionCore::EState ToDecisionState(EEnemyState State) { return (EnemyDecisionCore::EState)State; }
+static FORCEINLINE EnemyDecisionCore::EAction ToDecisionAction(EActionState Action) { return (EnemyDecisionCore::EAction)Action; }
+
+DECLARE_CYCLE_STAT(TEXT("Enemy AI Gather"), STAT_EnemyAIGather, STATGROUP_Rashepur);
+DECLARE_CYCLE_STAT(TEXT("Enemy AI Decide"), STAT_EnemyAIDecide, STATGROUP_Rashepur);
+DECLARE_CYCLE_STAT(TEXT("Enemy AI Apply"), STAT_EnemyAIApply, STATGROUP_Rashepur);
+DECLARE_CYCLE_STAT(TEXT("Enemy AI Significance"), STAT_EnemyAISignificance, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Registered Enemies"), STAT_EnemyAIRegistered, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemies Deciding"), STAT_EnemyAIDeciding, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Active Enemies"), STAT_EnemyAIActive, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Dormant Enemies"), STAT_EnemyAIDormant, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("LOD Tier 0 Enemies"), STAT_EnemyAITier0, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("LOD Tier 1 Enemies"), STAT_EnemyAITier1, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("LOD Tier 2 Enemies"), STAT_EnemyAITier2, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("LOD Tier 3+ Enemies"), STAT_EnemyAITier3, STATGROUP_Rashepur);
+DECLARE_CYCLE_STAT(TEXT("Enemy AI Anim Budget"), STAT_EnemyAIAnimBudget, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemies Anim Throttled By Budget"), STAT_EnemyAIAnimThrottled, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemies Anim Following A Leader"), STAT_EnemyAIAnimFollowing, STATGROUP_Rashepur);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Enemy Anim Estimated ms"), STAT_EnemyAIAnimEstimatedMs, STATGROUP_Rashepur);
+DECLARE_CYCLE_STAT(TEXT("Enemy AI Sensing Gate"), STAT_EnemyAISensingGate, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemies Sensing"), STAT_EnemyAISensing, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemies Sensing Gated Out"), STAT_EnemyAISensingGated, STATGROUP_Rashepur);
+
+void UEnemyAIManager::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	if (LODTierSettings.Num() == 0)
+	{
+		// MaxDistance, DecisionInterval, SensingInterval, MovementTickInterval, AnimTickRate
+		LODTierSettings.Add({ 2500.f, 0.f, 0.f, 0.f, 1 });
+		LODTierSettings.Add({ 6000.f, 0.1f, 1.f, 0.033f, 2 });
+		LODTierSettings.Add({ 12000.f, 0.25f, 2.f, 0.1f, 3 });
+		LODTierSettings.Add({ UE_BIG_NUMBER, 0.5f, 4.f, 0.25f, 3 });
+	}
+}
+
+void UEnemyAIManager::Deinitialize()
+{
+	for (AEnemy* Enemy : Enemies)
+	{
+		if (Enemy)
+			Enemy->AIManagerIndex = INDEX_NONE;
+	}
+	Enemies.Empty();
+	NumActive = 0;
+	Super::Deinitialize();
+}
+
+bool UEnemyAIManager::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UEnemyAIManager::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UEnemyAIManager, STATGROUP_Tickables);
+}
+
+void UEnemyAIManager::RegisterEnemy(AEnemy* Enemy)
+{
+	if (Enemy == nullptr || Enemy->AIManagerIndex != INDEX_NONE) return;
+
+	Enemy->AIManagerIndex = Enemies.Add(Enemy);
+	EnemyStates.Add(Enemy->EnemyState);
+	ActionStates.Add(Enemy->ActionState);
+	CombatTargetIndices.Add(INDEX_NONE);
+	const FVector Location = Enemy->GetActorLocation();
+	EnemyX.Add(Location.X);
+	EnemyY.Add(Location.Y);
+	EnemyZ.Add(Location.Z);
+	TargetX.AddZeroed();
+	TargetY.AddZeroed();
+	TargetZ.AddZeroed();
+	PatrolX.AddZeroed();
+	PatrolY.AddZeroed();
+	PatrolZ.AddZeroed();
+	CombatRadiusSquared.Add((float)FMath::Square(Enemy->CombatRadius));
+	AttackRadiusSquared.Add((float)FMath::Square(Enemy->AttackRadius));
+	PatrolRadiusSquared.Add((float)FMath::Square(Enemy->PatrolRadius));
+	DecisionTimers.Add(0.f);
+	LODTiers.Add(0);
+	AnimTickRates.Add(1);
+	SignificanceDistances.Add(0.f);
+	SensingEnabled.Add(1);
+	Flags.Add(0);
+	Decisions.Add(EEnemyAIDecision::EAD_None);
+	// a pooled enemy may come back with the rate of its last life
+	Enemy->SetAnimTickRate(1);
+	if (Enemy->PawnSensing)
+		MaxSightRadius = FMath::Max(MaxSightRadius, Enemy->PawnSensing->SightRadius);
+
+	// added dormant, then moved into the active range if its state needs decisions
+	SetEnemyActive(Enemy, Enemy->NeedsAIDecisions());
+}
+
+void UEnemyAIManager::UnregisterEnemy(AEnemy* Enemy)
+{
+	if (Enemy == nullptr || !Enemies.IsValidIndex(Enemy->AIManagerIndex)) return;
+
+	RemoveEnemyAtSwap(Enemy->AIManagerIndex);
+	Enemy->AIManagerIndex = INDEX_NONE;
+}
+
+void UEnemyAIManager::SetEnemyActive(AEnemy* Enemy, bool bActive)
+{
+	if (Enemy == nullptr || !Enemies.IsValidIndex(Enemy->AIManagerIndex)) return;
+
+	if (bApplyingDecisions)
+	{
+		PendingActivityChanges.AddUnique(Enemy);
+		return;
+	}
+
+	const int32 Index = Enemy->AIManagerIndex;
+	if (bActive && Index >= NumActive)
+	{
+		SwapEnemies(Index, NumActive);
+		DecisionTimers[NumActive] = 0.f;
+		++NumActive;
+	}
+	else if (!bActive && Index < NumActive)
+	{
+		--NumActive;
+		SwapEnemies(Index, NumActive);
+		Flags[NumActive] = 0;
+		Decisions[NumActive] = EEnemyAIDecision::EAD_None;
+	}
+}
+
+void UEnemyAIManager::SwapEnemies(int32 IndexA, int32 IndexB)
+{
+	if (IndexA == IndexB) return;
+
+	Enemies.Swap(IndexA, IndexB);
+	EnemyStates.Swap(IndexA, IndexB);
+	ActionStates.Swap(IndexA, IndexB);
+	CombatTargetIndices.Swap(IndexA, IndexB);
+	EnemyX.Swap(IndexA, IndexB);
+	EnemyY.Swap(IndexA, IndexB);
+	EnemyZ.Swap(IndexA, IndexB);
+	TargetX.Swap(IndexA, IndexB);
+	TargetY.Swap(IndexA, IndexB);
+	TargetZ.Swap(IndexA, IndexB);
+	PatrolX.Swap(IndexA, IndexB);
+	PatrolY.Swap(IndexA, IndexB);
+	PatrolZ.Swap(IndexA, IndexB);
+	CombatRadiusSquared.Swap(IndexA, IndexB);
+	AttackRadiusSquared.Swap(IndexA, IndexB);
+	PatrolRadiusSquared.Swap(IndexA, IndexB);
+	DecisionTimers.Swap(IndexA, IndexB);
+	LODTiers.Swap(IndexA, IndexB);
+	AnimTickRates.Swap(IndexA, IndexB);
+	SignificanceDistances.Swap(IndexA, IndexB);
+	SensingEnabled.Swap(IndexA, IndexB);
+	Flags.Swap(IndexA, IndexB);
+	Decisions.Swap(IndexA, IndexB);
+
+	if (Enemies[IndexA])
+		Enemies[IndexA]->AIManagerIndex = IndexA;
+	if (Enemies[IndexB])
+		Enemies[IndexB]->AIManagerIndex = IndexB;
+}
+
+void UEnemyAIManager::RemoveEnemyAtSwap(int32 Index)
+{
+	// keep the active range packed, the removed slot is first moved to the end of it
+	if (Index < NumActive)
+	{
+		--NumActive;
+		SwapEnemies(Index, NumActive);
+		Index = NumActive;
+	}
+
+	Enemies.RemoveAtSwap(Index, 1, false);
+	EnemyStates.RemoveAtSwap(Index, 1, false);
+	ActionStates.RemoveAtSwap(Index, 1, false);
+	CombatTargetIndices.RemoveAtSwap(Index, 1, false);
+	EnemyX.RemoveAtSwap(Index, 1, false);
+	EnemyY.RemoveAtSwap(Index, 1, false);
+	EnemyZ.RemoveAtSwap(Index, 1, false);
+	TargetX.RemoveAtSwap(Index, 1, false);
+	TargetY.RemoveAtSwap(Index, 1, false);
+	TargetZ.RemoveAtSwap(Index, 1, false);
+	PatrolX.RemoveAtSwap(Index, 1, false);
+	PatrolY.RemoveAtSwap(Index, 1, false);
+	PatrolZ.RemoveAtSwap(Index, 1, false);
+	CombatRadiusSquared.RemoveAtSwap(Index, 1, false);
+	AttackRadiusSquared.RemoveAtSwap(Index, 1, false);
+	PatrolRadiusSquared.RemoveAtSwap(Index, 1, false);
+	DecisionTimers.RemoveAtSwap(Index, 1, false);
+	LODTiers.RemoveAtSwap(Index, 1, false);
+	AnimTickRates.RemoveAtSwap(Index, 1, false);
+	SignificanceDistances.RemoveAtSwap(Index, 1, false);
+	SensingEnabled.RemoveAtSwap(Index, 1, false);
+	Flags.RemoveAtSwap(Index, 1, false);
+	Decisions.RemoveAtSwap(Index, 1, false);
+
+	// the last enemy moved into the freed slot
+	if (Enemies.IsValidIndex(Index) && Enemies[Index])
+		Enemies[Index]->AIManagerIndex = Index;
+}
+
+void UEnemyAIManager::Tick(float DeltaTime)
+{
+	SET_DWORD_STAT(STAT_EnemyAIRegistered, Enemies.Num());
+	SET_DWORD_STAT(STAT_EnemyAIActive, NumActive);
+	SET_DWORD_STAT(STAT_EnemyAIDormant, Enemies.Num() - NumActive);
+	if (Enemies.Num() == 0) return;
+
+	UpdateSignificance(DeltaTime);
+	GatherEnemyState(DeltaTime);
+	ComputeRangeFlags();
+	QueryVisibility();
+	RunDecisionPass();
+	ApplyDecisions();
+}
+
+void UEnemyAIManager::UpdateSignificance(float DeltaTime)
+{
+	SignificanceTimer += DeltaTime;
+	if (SignificanceTimer < SignificanceUpdateInterval) return;
+	SignificanceTimer = 0.f;
+
+	SCOPE_CYCLE_COUNTER(STAT_EnemyAISignificance);
+
+	const APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	const APawn* Hero = PlayerController ? PlayerController->GetPawn() : nullptr;
+	if (Hero == nullptr) return;
+
+	const FVector HeroLocation = Hero->GetActorLocation();
+	const double OffscreenScaleSquared = FMath::Square(OffscreenDistanceScale);
+	uint32 TierCounts[4] = { 0, 0, 0, 0 };
+
+	const int32 NumEnemies = Enemies.Num();
+	for (int32 Index = 0; Index < NumEnemies; ++Index)
+	{
+		AEnemy* Enemy = Enemies[Index];
+		int32 TierIndex = 0;
+		SignificanceDistances[Index] = -1.f;
+
+		// anyone fighting keeps full rate no matter how far they are
+		if (Enemy->EnemyState <= EEnemyState::EES_Patrolling)
+		{
+			double SignificanceDistSquared = FVector::DistSquared(Enemy->GetActorLocation(), HeroLocation);
+			if (!Enemy->GetMesh()->WasRecentlyRendered(0.2f))
+				SignificanceDistSquared *= OffscreenScaleSquared;
+			TierIndex = SelectLODTier(SignificanceDistSquared);
+			SignificanceDistances[Index] = (float)SignificanceDistSquared;
+		}
+
+		if (TierIndex != LODTiers[Index])
+			SetLODTier(Index, TierIndex);
+		++TierCounts[FMath::Min(TierIndex, 3)];
+	}
+
+	SET_DWORD_STAT(STAT_EnemyAITier0, TierCounts[0]);
+	SET_DWORD_STAT(STAT_EnemyAITier1, TierCounts[1]);
+	SET_DWORD_STAT(STAT_EnemyAITier2, TierCounts[2]);
+	SET_DWORD_STAT(STAT_EnemyAITier3, TierCounts[3]);
+
+	UpdateSensingGate(HeroLocation);
+	UpdateAnimBudget();
+}
+
+void UEnemyAIManager::UpdateSensingGate(const FVector& HeroLocation)
+{
+	SCOPE_CYCLE_COUNTER(STAT_EnemyAISensingGate);
+
+	// without the hash every enemy keeps sensing, as before
+	const int32 NumEnemies = Enemies.Num();
+	const USpatialHashSubsystem* SpatialHash = GetWorld()->GetSubsystem<USpatialHashSubsystem>();
+	SensingInRange.Init(SpatialHash ? 0 : 1, NumEnemies);
+	if (SpatialHash)
+	{
+		// a PawnSensing update of an enemy farther than its SightRadius only fails CouldSeePawn's distance check
+		SpatialHash->ForEachInRadius(HeroLocation, MaxSightRadius + SensingGateMargin, ESpatialCategory::Enemy, [this](AActor* Actor, double DistSquared)
+		{
+			const AEnemy* Enemy = Cast<AEnemy>(Actor);
+			if (Enemy && Enemies.IsValidIndex(Enemy->AIManagerIndex) && Enemy->PawnSensing &&
+				DistSquared <= FMath::Square((double)Enemy->PawnSensing->SightRadius + SensingGateMargin))
+			{
+				SensingInRange[Enemy->AIManagerIndex] = 1;
+			}
+		});
+	}
+
+	uint32 NumSensing = 0;
+	for (int32 Index = 0; Index < NumEnemies; ++Index)
+	{
+		// only patrollers wait on OnSeePawn, fighting enemies keep sensing wherever they are
+		AEnemy* Enemy = Enemies[Index];
+		const uint8 bEnabled = (Enemy->EnemyState != EEnemyState::EES_Patrolling || SensingInRange[Index]) ? 1 : 0;
+		if (bEnabled != SensingEnabled[Index])
+		{
+			SensingEnabled[Index] = bEnabled;
+			Enemy->SetSensingInRange(bEnabled != 0);
+		}
+		NumSensing += bEnabled;
+	}
+
+	SET_DWORD_STAT(STAT_EnemyAISensing, NumSensing);
+	SET_DWORD_STAT(STAT_EnemyAISensingGated, NumEnemies - NumSensing);
+}
+
+void UEnemyAIManager::UpdateAnimBudget()
+{
+	SCOPE_CYCLE_COUNTER(STAT_EnemyAIAnimBudget);
+
+	// every enemy starts at its tier's rate, fighting enemies (no significance distance) at full rate
+	const int32 NumEnemies = Enemies.Num();
+	const int32 MaxRate = FMath::Clamp(MaxAnimTickRate, 1, 255);
+	const UEnemyAnimSharingSubsystem* AnimSharing = GetWorld()->GetSubsystem<UEnemyAnimSharingSubsystem>();
+	AnimTargetRates.SetNumUninitialized(NumEnemies, false);
+	AnimLeaderIndices.SetNumUninitialized(NumEnemies, false);
+	AnimBudgetPriorities.SetNumUninitialized(NumEnemies, false);
+	for (int32 Index = 0; Index < NumEnemies; ++Index)
+	{
+		int32 Rate = 1;
+		if (SignificanceDistances[Index] >= 0.f && LODTierSettings.IsValidIndex(LODTiers[Index]))
+			Rate = FMath::Clamp(LODTierSettings[LODTiers[Index]].AnimTickRate, 1, MaxRate);
+		AnimTargetRates[Index] = (uint8)Rate;
+		AnimBudgetPriorities[Index] = SignificanceDistances[Index];
+
+		AnimLeaderIndices[Index] = INDEX_NONE;
+		const AEnemy* Leader = AnimSharing ? AnimSharing->GetLeader(Enemies[Index]) : nullptr;
+		if (Leader && Leader != Enemies[Index] && Enemies.IsValidIndex(Leader->AIManagerIndex))
+			AnimLeaderIndices[Index] = Leader->AIManagerIndex;
+	}
+
+	// followers show the leader's pose, so the leader updates as often as its most significant follower needs
+	for (int32 Index = 0; Index < NumEnemies; ++Index)
+	{
+		const int32 LeaderIndex = AnimLeaderIndices[Index];
+		if (LeaderIndex == INDEX_NONE) continue;
+
+		AnimTargetRates[LeaderIndex] = FMath::Min(AnimTargetRates[LeaderIndex], AnimTargetRates[Index]);
+		if (AnimBudgetPriorities[Index] < 0.f || AnimBudgetPriorities[LeaderIndex] < 0.f)
+			AnimBudgetPriorities[LeaderIndex] = -1.f;
+		else
+			AnimBudgetPriorities[LeaderIndex] = FMath::Min(AnimBudgetPriorities[LeaderIndex], AnimBudgetPriorities[Index]);
+	}
+
+	// a follower skips its own evaluation, only everyone else counts against the budget
+	float EstimatedMs = 0.f;
+	uint32 NumFollowing = 0;
+	AnimBudgetOrder.Reset();
+	for (int32 Index = 0; Index < NumEnemies; ++Index)
+	{
+		if (AnimLeaderIndices[Index] != INDEX_NONE)
+		{
+			++NumFollowing;
+			continue;
+		}
+		EstimatedMs += EstimatedAnimMsPerEnemy / AnimTargetRates[Index];
+		if (AnimBudgetPriorities[Index] >= 0.f)
+			AnimBudgetOrder.Add(Index);
+	}
+
+	// over budget: the least significant idle enemies drop to the slowest rate first
+	uint32 NumThrottled = 0;
+	if (EstimatedMs > AnimBudgetMs)
+	{
+		AnimBudgetOrder.Sort([this](int32 A, int32 B) { return AnimBudgetPriorities[A] > AnimBudgetPriorities[B]; });
+		for (const int32 Index : AnimBudgetOrder)
+		{
+			if (EstimatedMs <= AnimBudgetMs) break;
+			EstimatedMs -= EstimatedAnimMsPerEnemy / AnimTargetRates[Index] - EstimatedAnimMsPerEnemy / MaxRate;
+			AnimTargetRates[Index] = (uint8)MaxRate;
+			++NumThrottled;
+		}
+	}
+
+	for (int32 Index = 0; Index < NumEnemies; ++Index)
+	{
+		if (AnimTargetRates[Index] != AnimTickRates[Index])
+		{
+			AnimTickRates[Index] = AnimTargetRates[Index];
+			Enemies[Index]->SetAnimTickRate(AnimTickRates[Index]);
+		}
+	}
+
+	SET_DWORD_STAT(STAT_EnemyAIAnimThrottled, NumThrottled);
+	SET_DWORD_STAT(STAT_EnemyAIAnimFollowing, NumFollowing);
+	SET_FLOAT_STAT(STAT_EnemyAIAnimEstimatedMs, EstimatedMs);
+}
+
+int32 UEnemyAIManager::SelectLODTier(double SignificanceDistSquared) const
+{
+	const int32 LastTier = LODTierSettings.Num() - 1;
+	for (int32 TierIndex = 0; TierIndex < LastTier; ++TierIndex)
+	{
+		if (SignificanceDistSquared <= FMath::Square((double)LODTierSettings[TierIndex].MaxDistance))
+			return TierIndex;
+	}
+	return FMath::Max(LastTier, 0);
+}
+
+void UEnemyAIManager::SetLODTier(int32 Index, int32 TierIndex)
+{
+	LODTiers[Index] = (uint8)TierIndex;
+	if (LODTierSettings.IsValidIndex(TierIndex))
+		Enemies[Index]->ApplyAILODTier(LODTierSettings[TierIndex]);
+}
+
+int32 UEnemyAIManager::FindOrAddFrameTarget(APawn* Target)
+{
+	if (Target == nullptr) return INDEX_NONE;
+
+	// few distinct targets per frame (usually just the hero), a linear search beats hashing here
+	int32 TargetIndex = FrameTargets.Find(Target);
+	if (TargetIndex == INDEX_NONE)
+	{
+		TargetIndex = FrameTargets.Add(Target);
+		FrameTargetLocations.Add(Target->GetActorLocation());
+		FrameTargetDead.Add(UCombatStatusComponent::HasStatus(Target, ECombatStatus::ECST_Dead));
+	}
+	return TargetIndex;
+}
+
+void UEnemyAIManager::GatherEnemyState(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_EnemyAIGather);
+
+	FrameTargets.Reset();
+	FrameTargetLocations.Reset();
+	FrameTargetDead.Reset();
+
+	uint32 NumDeciding = 0;
+	const int32 NumEnemies = NumActive;
+	for (int32 Index = 0; Index < NumEnemies; ++Index)
+	{
+		DecisionTimers[Index] += DeltaTime;
+		if (LODTierSettings.IsValidIndex(LODTiers[Index]) && DecisionTimers[Index] < LODTierSettings[LODTiers[Index]].DecisionInterval)
+		{
+			Flags[Index] = 0;
+			continue;
+		}
+
+		AEnemy* Enemy = Enemies[Index];
+		EnemyStates[Index] = Enemy->EnemyState;
+		ActionStates[Index] = Enemy->ActionState;
+		++NumDeciding;
+
+		const FVector Location = Enemy->GetActorLocation();
+		EnemyX[Index] = Location.X;
+		EnemyY[Index] = Location.Y;
+		EnemyZ[Index] = Location.Z;
+
+		uint8 EnemyFlags = EnemyAIFlags::DecisionDue;
+		const int32 TargetIndex = FindOrAddFrameTarget(Enemy->CombatTarget);
+		CombatTargetIndices[Index] = TargetIndex;
+		if (TargetIndex != INDEX_NONE)
+		{
+			const FVector& TargetLocation = FrameTargetLocations[TargetIndex];
+			TargetX[Index] = TargetLocation.X;
+			TargetY[Index] = TargetLocation.Y;
+			TargetZ[Index] = TargetLocation.Z;
+			EnemyFlags |= EnemyAIFlags::HasCombatTarget;
+			if (FrameTargetDead[TargetIndex])
+				EnemyFlags |= EnemyAIFlags::CombatTargetDead;
+		}
+		if (Enemy->PatrolTarget)
+		{
+			const FVector PatrolLocation = Enemy->PatrolTarget->GetActorLocation();
+			PatrolX[Index] = PatrolLocation.X;
+			PatrolY[Index] = PatrolLocation.Y;
+			PatrolZ[Index] = PatrolLocation.Z;
+			EnemyFlags |= EnemyAIFlags::HasPatrolTarget;
+		}
+		Flags[Index] = EnemyFlags;
+	}
+	SET_DWORD_STAT(STAT_EnemyAIDeciding, NumDeciding);
+}
+
+template<typename ChunkBodyType>
+void UEnemyAIManager::ForEachActiveChunk(ChunkBodyType&& ChunkBody) const
+{
+	// every enemy is written by exactly one chunk from its own inputs, so the result matches a serial run
+	const int32 ChunkSize = Align(FMath::Max(CVarEnemyAIParallelChunkSize.GetValueOnGameThread(), 4), 4);
+	const int32 NumChunks = FMath::DivideAndRoundUp(NumActive, ChunkSize);
+	const EParallelForFlags ParallelFlags = CVarEnemyAIParallelDecide.GetValueOnGameThread() && NumChunks > 1
+		? EParallelForFlags::None
+		: EParallelForFlags::ForceSingleThread;
+
+	ParallelFor(NumChunks, [this, ChunkSize, &ChunkBody](int32 Chunk)
+	{
+		const int32 Start = Chunk * ChunkSize;
+		ChunkBody(Start, FMath::Min(Start + ChunkSize, NumActive));
+	}, ParallelFlags);
+}
+
+FEnemyRangeKernelInput UEnemyAIManager::MakeRangeKernelInput(int32 Start, int32 Count) const
+{
+	return FEnemyRangeKernelInput{
+		MakeArrayView(EnemyX.GetData() + Start, Count), MakeArrayView(EnemyY.GetData() + Start, Count), MakeArrayView(EnemyZ.GetData() + Start, Count),
+		MakeArrayView(TargetX.GetData() + Start, Count), MakeArrayView(TargetY.GetData() + Start, Count), MakeArrayView(TargetZ.GetData() + Start, Count),
+		MakeArrayView(PatrolX.GetData() + Start, Count), MakeArrayView(PatrolY.GetData() + Start, Count), MakeArrayView(PatrolZ.GetData() + Start, Count),
+		MakeArrayView(CombatRadiusSquared.GetData() + Start, Count), MakeArrayView(AttackRadiusSquared.GetData() + Start, Count), MakeArrayView(PatrolRadiusSquared.GetData() + Start, Count) };
+}
+
+void UEnemyAIManager::ComputeRangeFlags()
+{
+	SCOPE_CYCLE_COUNTER(STAT_EnemyAIDecide);
+
+#if !UE_BUILD_SHIPPING
+	VerifyGatheredFlags.Reset();
+	if (CVarEnemyAIVerifyParallelDecide.GetValueOnGameThread())
+		VerifyGatheredFlags.Append(Flags.GetData(), NumActive);
+#endif
+
+	// enemies that are not due this frame have no target bits set, so they get no band bits either
+	ForEachActiveChunk([this](int32 Start, int32 End)
+	{
+		EnemyRangeKernel::ComputeRangeFlags(MakeRangeKernelInput(Start, End - Start), MakeArrayView(Flags.GetData() + Start, End - Start));
+	});
+}
+
+void UEnemyAIManager::QueryVisibility()
+{
+	// sight is only needed by enemies in combat with a target inside their combat radius
+	const int32 NumEnemies = NumActive;
+	for (int32 Index = 0; Index < NumEnemies; ++Index)
+	{
+		if ((Flags[Index] & EnemyAIFlags::DecisionDue) &&
+			EnemyStates[Index] > EEnemyState::EES_Patrolling &&
+			(Flags[Index] & EnemyAIFlags::InCombatRadius))
+		{
+			AEnemy* Enemy = Enemies[Index];
+			if (Enemy->CanSeeTarget(Enemy->CombatTarget))
+				Flags[Index] |= EnemyAIFlags::CanSeeTarget;
+		}
+	}
+}
+
+void UEnemyAIManager::RunDecisionPass()
+{
+	SCOPE_CYCLE_COUNTER(STAT_EnemyAIDecide);
+
+	ForEachActiveChunk([this](int32 Start, int32 End)
+	{
+		for (int32 Index = Start; Index < End; ++Index)
+			Decisions[Index] = EnemyDecisionCore::Decide(ToDecisionState(EnemyStates[Index]), ToDecisionAction(ActionStates[Index]), Flags[Index]);
+	});
+
+#if !UE_BUILD_SHIPPING
+	if (VerifyGatheredFlags.Num() == NumActive && CVarEnemyAIVerifyParallelDecide.GetValueOnGameThread())
+		VerifyParallelPasses();
+#endif
+}
+
+void UEnemyAIManager::VerifyParallelPasses()
+{
+	// one kernel call over the whole active range on this thread, so no chunk edge or four-wide tail falls where the parallel run put them
+	VerifyFlags = VerifyGatheredFlags;
+	EnemyRangeKernel::ComputeRangeFlags(MakeRangeKernelInput(0, NumActive), VerifyFlags);
+
+	uint32 NumMismatches = 0;
+	for (int32 Index = 0; Index < NumActive; ++Index)
+	{
+		// sight is queried on the game thread between the passes, take its bit as it is
+		VerifyFlags[Index] |= Flags[Index] & EnemyAIFlags::CanSeeTarget;
+		const EEnemyAIDecision Serial = EnemyDecisionCore::Decide(ToDecisionState(EnemyStates[Index]), ToDecisionAction(ActionStates[Index]), VerifyFlags[Index]);
+		if (VerifyFlags[Index] != Flags[Index] || Serial != Decisions[Index])
+		{
+			++NumMismatches;
+			UE_LOG(LogTemp, Error, TEXT("Parallel decide mismatch for %s at %d: flags 0x%02x decision %d, serial flags 0x%02x decision %d"),
+				*GetNameSafe(Enemies[Index]), Index, Flags[Index], (int32)Decisions[Index], VerifyFlags[Index], (int32)Serial);
+		}
+	}
+	if (NumMismatches > 0)
+		UE_LOG(LogTemp, Error, TEXT("Parallel decide: %u of %d active enemies differ from a serial run"), NumMismatches, NumActive);
+}
+
+void UEnemyAIManager::ApplyDecisions()
+{
+	SCOPE_CYCLE_COUNTER(STAT_EnemyAIApply);
+
+	// a decision can change the enemy's state, activity changes wait until the loop is done so no slot moves under it
+	bApplyingDecisions = true;
+	for (int32 Index = 0; Index < NumActive; ++Index)
+	{
+		if (!(Flags[Index] & EnemyAIFlags::DecisionDue)) continue;
+
+		const float DecisionDeltaTime = DecisionTimers[Index];
+		DecisionTimers[Index] = 0.f;
+
+		const EEnemyState EnemyState = EnemyStates[Index];
+		if (EnemyState == EEnemyState::EES_Dead || EnemyState == EEnemyState::EES_Staggered) continue;
+
+		AEnemy* Enemy = Enemies[Index];
+		Enemy->ApplyAIDecision(Decisions[Index], (Flags[Index] & EnemyAIFlags::InCombatRadius) != 0, DecisionDeltaTime);
+	}
+	bApplyingDecisions = false;
+
+	for (AEnemy* Enemy : PendingActivityChanges)
+	{
+		if (Enemy)
+			SetEnemyActive(Enemy, Enemy->NeedsAIDecisions());
+	}
+	PendingActivityChanges.Reset();
+}
+
+#if !UE_BUILD_SHIPPING
+
+/** Patrollers waiting on PatrolTimer and corpses must stay past NumActive and tick nothing, checked every frame after the actors ticked */
+struct FEnemyDormancySoak
+{
+	TWeakObjectPtr<UWorld> World;
+	TArray<TWeakObjectPtr<AEnemy>> Patrollers;
+	TArray<TWeakObjectPtr<AEnemy>> Corpses;
+	int32 NumFrames = 0;
+	int32 Frame = 0;
+	int32 NumFailures = 0;
+	FDelegateHandle PostActorTickHandle;
+
+	static TUniquePtr<FEnemyDormancySoak> Running;
+
+	/** Frames the spawned enemies get to land and pick up their first move before they are put to sleep */
+	static constexpr int32 SettleFrames = 30;
+
+	void Fail(const AEnemy& Enemy, const TCHAR* Reason)
+	{
+		++NumFailures;
+		UE_LOG(LogTemp, Error, TEXT("DormancySoak FAILED at frame %d: %s %s"), Frame - SettleFrames, *Enemy.GetName(), Reason);
+	}
+
+	static bool IsTicking(const FTickFunction& TickFunction)
+	{
+		return TickFunction.IsTickFunctionRegistered() && TickFunction.IsTickFunctionEnabled();
+	}
+
+	void PutToSleep(APlayerController* Killer)
+	{
+		for (const TWeakObjectPtr<AEnemy>& Patroller : Patrollers)
+		{
+			AEnemy* Enemy = Patroller.Get();
+			if (Enemy == nullptr) continue;
+
+			// sight would rightly wake it, the soak is about what happens while nothing does
+			if (Enemy->PawnSensing)
+				Enemy->PawnSensing->SetSensingUpdatesEnabled(false);
+			if (Enemy->EnemyController)
+				Enemy->EnemyController->StopMovement();
+			Enemy->ReachedPatrolTarget();
+			// longer than any soak, PatrolTimer is still what it waits on
+			Enemy->GetWorldTimerManager().SetTimer(Enemy->PatrolTimer, Enemy, &AEnemy::PatrolTimerFinished, 3600.f);
+		}
+		for (const TWeakObjectPtr<AEnemy>& Corpse : Corpses)
+		{
+			AEnemy* Enemy = Corpse.Get();
+			if (Enemy == nullptr) continue;
+
+			UGameplayStatics::ApplyDamage(Enemy, Enemy->CharAttributes->GetMaxHealth(), Killer, Killer->GetPawn(), UDamageType::StaticClass());
+			Enemy->Die();
+			// the body stays for the whole soak, it is released at the end
+			Enemy->GetWorldTimerManager().ClearTimer(Enemy->DeathCleanupTimer);
+		}
+	}
+
+	void Check(const UEnemyAIManager& AIManager)
+	{
+		auto CheckDormant = [this, &AIManager](const AEnemy& Enemy)
+		{
+			if (Enemy.AIManagerIndex == INDEX_NONE)
+				Fail(Enemy, TEXT("is not registered with the AI manager"));
+			else if (Enemy.AIManagerIndex < AIManager.NumActive)
+				Fail(Enemy, TEXT("sits in the active range"));
+			if (IsTicking(Enemy.PrimaryActorTick))
+				Fail(Enemy, TEXT("ticks the actor"));
+			if (IsTicking(Enemy.GetCharacterMovement()->PrimaryComponentTick))
+				Fail(Enemy, TEXT("ticks CharacterMovement"));
+		};
+
+		for (const TWeakObjectPtr<AEnemy>& Patroller : Patrollers)
+		{
+			if (const AEnemy* Enemy = Patroller.Get())
+			{
+				if (!Enemy->IsPatrolling() || !Enemy->bWaitingAtPatrolPoint)
+					Fail(*Enemy, TEXT("stopped waiting at its patrol point"));
+				CheckDormant(*Enemy);
+			}
+		}
+		for (const TWeakObjectPtr<AEnemy>& Corpse : Corpses)
+		{
+			if (const AEnemy* Enemy = Corpse.Get())
+			{
+				if (!Enemy->IsDead())
+					Fail(*Enemy, TEXT("left Dead"));
+				CheckDormant(*Enemy);
+			}
+		}
+	}
+
+	void Finish()
+	{
+		FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+		for (const TWeakObjectPtr<AEnemy>& Enemy : Patrollers)
+			if (Enemy.IsValid())
+				Enemy->ReleaseToPool();
+		for (const TWeakObjectPtr<AEnemy>& Enemy : Corpses)
+			if (Enemy.IsValid())
+				Enemy->ReleaseToPool();
+
+		if (NumFailures > 0)
+		{
+			UE_LOG(LogTemp, Error, TEXT("DormancySoak FAILED: %d failures over %d frames"), NumFailures, Frame - SettleFrames);
+		}
+		else
+		{
+			UE_LOG(LogTemp, Display, TEXT("DormancySoak passed: %d waiting patrollers and %d corpses stayed dormant and ticked nothing for %d frames"), Patrollers.Num(), Corpses.Num(), NumFrames);
+		}
+		Running.Reset();
+	}
+
+	void OnPostActorTick(UWorld* TickedWorld)
+	{
+		UWorld* SoakWorld = World.Get();
+		const UEnemyAIManager* AIManager = SoakWorld ? SoakWorld->GetSubsystem<UEnemyAIManager>() : nullptr;
+		if (AIManager == nullptr)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("DormancySoak aborted, its world went away"));
+			FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+			Running.Reset();
+			return;
+		}
+		if (TickedWorld != SoakWorld) return;
+
+		++Frame;
+		if (Frame == SettleFrames)
+		{
+			APlayerController* Killer = SoakWorld->GetFirstPlayerController();
+			if (Killer == nullptr || Killer->GetPawn() == nullptr)
+			{
+				UE_LOG(LogTemp, Warning, TEXT("DormancySoak aborted, the hero went away"));
+				Finish();
+				return;
+			}
+			PutToSleep(Killer);
+		}
+		else if (Frame > SettleFrames)
+		{
+			Check(*AIManager);
+			if (Frame - SettleFrames >= NumFrames)
+				Finish();
+		}
+	}
+
+	static void Start(UWorld* World, int32 NumEnemies, int32 NumFrames)
+	{
+		UEnemyPoolSubsystem* Pool = World ? World->GetSubsystem<UEnemyPoolSubsystem>() : nullptr;
+		const APlayerController* Killer = World ? World->GetFirstPlayerController() : nullptr;
+		TActorIterator<AEnemy> Template(World);
+		if (Pool == nullptr || !Template || Killer == nullptr || Killer->GetPawn() == nullptr || World->GetSubsystem<UEnemyAIManager>() == nullptr)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("DormancySoak needs a game world with a possessed hero and at least one enemy"));
+			return;
+		}
+		if (Running.IsValid())
+		{
+			UE_LOG(LogTemp, Warning, TEXT("DormancySoak is already running"));
+			return;
+		}
+
+		Running = MakeUnique<FEnemyDormancySoak>();
+		FEnemyDormancySoak& Soak = *Running;
+		Soak.World = World;
+		Soak.NumFrames = FMath::Max(NumFrames, 1);
+
+		// a grid next to the first enemy, half of it patrols and waits, the other half dies
+		const TSubclassOf<AEnemy> EnemyClass = Template->GetClass();
+		const FTransform Origin = Template->GetActorTransform();
+		const TArray<AActor*> NoPatrolTargets;
+		const int32 Columns = FMath::CeilToInt(FMath::Sqrt((float)(NumEnemies * 2)));
+		for (int32 Index = 0; Index < NumEnemies * 2; ++Index)
+		{
+			FTransform Transform = Origin;
+			Transform.AddToTranslation(FVector((Index % Columns + 1) * 300.0, (Index / Columns + 1) * 300.0, 0.0));
+			if (AEnemy* Enemy = Pool->SpawnEnemy(EnemyClass, Transform, NoPatrolTargets, nullptr))
+				(Index % 2 ? Soak.Corpses : Soak.Patrollers).Add(Enemy);
+		}
+
+		Soak.PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddLambda([](UWorld* TickedWorld, ELevelTick, float)
+		{
+			if (Running.IsValid())
+				Running->OnPostActorTick(TickedWorld);
+		});
+	}
+};
+
+TUniquePtr<FEnemyDormancySoak> FEnemyDormancySoak::Running;
+
+namespace EnemyDormancySoak
+{
+	static FAutoConsoleCommandWithWorldAndArgs SoakCommand(
+		TEXT("Rashepur.AI.DormancySoak"),
+		TEXT("Rashepur.AI.DormancySoak [Enemies] [Frames] - spawns patrollers waiting on PatrolTimer and corpses, then fails if any of them ticks the actor or CharacterMovement or sits in the AI manager's active range"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			FEnemyDormancySoak::Start(World, Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 50, Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 300);
+		}));
+}
+
+#endif
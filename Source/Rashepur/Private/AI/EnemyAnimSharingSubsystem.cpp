@@ -0,0 +1,126 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AI/EnemyAnimSharingSubsystem.h"
+#include "Rashepur.h"
+#include "Enemy/Enemy.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<bool> CVarEnemyAnimSharing(
+	TEXT("Rashepur.Anim.ShareLeaderPose"),
+	true,
+	TEXT("Enemies of the same archetype patrolling, idling or searching follow one leader pose instead of evaluating their own"));
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Anim Share Leaders"), STAT_AnimShareLeaders, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Anim Share Followers"), STAT_AnimShareFollowers, STATGROUP_Rashepur);
+
+void UEnemyAnimSharingSubsystem::Deinitialize()
+{
+	Groups.Empty();
+	Super::Deinitialize();
+}
+
+bool UEnemyAnimSharingSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+bool UEnemyAnimSharingSubsystem::IsEnabled()
+{
+	return CVarEnemyAnimSharing.GetValueOnGameThread();
+}
+
+UEnemyAnimSharingSubsystem::FShareKey UEnemyAnimSharingSubsystem::MakeKey(const AEnemy* Enemy, EEnemyAnimShareState State)
+{
+	const USkeletalMeshComponent* Mesh = Enemy->GetMesh();
+	return FShareKey(Mesh->GetSkeletalMeshAsset(), Mesh->GetAnimClass(), State);
+}
+
+void UEnemyAnimSharingSubsystem::SetShareState(AEnemy* Enemy, EEnemyAnimShareState NewState)
+{
+	if (Enemy == nullptr || Enemy->AnimShareState == NewState) return;
+
+	if (Enemy->AnimShareState != EEnemyAnimShareState::None)
+		Leave(Enemy, Enemy->AnimShareState);
+	Enemy->AnimShareState = NewState;
+	if (NewState != EEnemyAnimShareState::None)
+		Join(Enemy, NewState);
+}
+
+AEnemy* UEnemyAnimSharingSubsystem::GetLeader(const AEnemy* Enemy) const
+{
+	if (Enemy == nullptr || Enemy->AnimShareState == EEnemyAnimShareState::None) return nullptr;
+
+	const FShareGroup* Group = Groups.Find(MakeKey(Enemy, Enemy->AnimShareState));
+	return Group ? Group->Leader.Get() : nullptr;
+}
+
+void UEnemyAnimSharingSubsystem::Join(AEnemy* Enemy, EEnemyAnimShareState State)
+{
+	FShareGroup& Group = Groups.FindOrAdd(MakeKey(Enemy, State));
+	if (AEnemy* Leader = Group.Leader.Get())
+	{
+		Group.Followers.Add(Enemy);
+		Follow(Enemy, Leader);
+		INC_DWORD_STAT(STAT_AnimShareFollowers);
+		return;
+	}
+
+	Group.Leader = Enemy;
+	SetLeading(Enemy, true);
+	INC_DWORD_STAT(STAT_AnimShareLeaders);
+}
+
+void UEnemyAnimSharingSubsystem::Leave(AEnemy* Enemy, EEnemyAnimShareState State)
+{
+	const FShareKey Key = MakeKey(Enemy, State);
+	FShareGroup* Group = Groups.Find(Key);
+	if (Group == nullptr) return;
+
+	if (Group->Leader != Enemy)
+	{
+		Group->Followers.RemoveSwap(Enemy);
+		Follow(Enemy, nullptr);
+		DEC_DWORD_STAT(STAT_AnimShareFollowers);
+		return;
+	}
+
+	SetLeading(Enemy, false);
+	DEC_DWORD_STAT(STAT_AnimShareLeaders);
+
+	// any follower can take over, they all show the same pose
+	Group->Leader = nullptr;
+	while (Group->Followers.Num() > 0 && !Group->Leader.IsValid())
+		Group->Leader = Group->Followers.Pop(false);
+
+	AEnemy* NewLeader = Group->Leader.Get();
+	if (NewLeader == nullptr)
+	{
+		Groups.Remove(Key);
+		return;
+	}
+
+	Follow(NewLeader, nullptr);
+	SetLeading(NewLeader, true);
+	DEC_DWORD_STAT(STAT_AnimShareFollowers);
+	INC_DWORD_STAT(STAT_AnimShareLeaders);
+	for (const TWeakObjectPtr<AEnemy>& Follower : Group->Followers)
+	{
+		if (AEnemy* FollowerEnemy = Follower.Get())
+			Follow(FollowerEnemy, NewLeader);
+	}
+}
+
+void UEnemyAnimSharingSubsystem::Follow(AEnemy* Follower, AEnemy* Leader)
+{
+	Follower->GetMesh()->SetLeaderPoseComponent(Leader ? Leader->GetMesh() : nullptr, true);
+}
+
+void UEnemyAnimSharingSubsystem::SetLeading(AEnemy* Enemy, bool bLeading)
+{
+	// followers copy the leader's bones, so the leader refreshes them even when it is off screen itself
+	USkeletalMeshComponent* Mesh = Enemy->GetMesh();
+	Mesh->VisibilityBasedAnimTickOption = bLeading ? EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones
+		: Enemy->GetClass()->GetDefaultObject<AEnemy>()->GetMesh()->VisibilityBasedAnimTickOption;
+}
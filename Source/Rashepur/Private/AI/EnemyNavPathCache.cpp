@@ -0,0 +1,129 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AI/EnemyNavPathCache.h"
+#include "Rashepur.h"
+#include "AIController.h"
+#include "NavigationSystem.h"
+#include "NavMesh/RecastNavMesh.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Nav Path Cache Hits"), STAT_EnemyNavPathCacheHits, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Nav Path Cache Misses"), STAT_EnemyNavPathCacheMisses, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Nav Repaths Suppressed"), STAT_EnemyNavRepathsSuppressed, STATGROUP_Rashepur);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Nav Repaths Per Second"), STAT_EnemyNavRepathsPerSecond, STATGROUP_Rashepur);
+
+void UEnemyNavPathCache::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+	if (UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(&InWorld))
+		NavSys->OnNavigationGenerationFinishedDelegate.AddDynamic(this, &UEnemyNavPathCache::OnNavigationGenerationFinished);
+}
+
+void UEnemyNavPathCache::Deinitialize()
+{
+	if (UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld()))
+		NavSys->OnNavigationGenerationFinishedDelegate.RemoveDynamic(this, &UEnemyNavPathCache::OnNavigationGenerationFinished);
+	Flush();
+	Super::Deinitialize();
+}
+
+bool UEnemyNavPathCache::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UEnemyNavPathCache::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UEnemyNavPathCache, STATGROUP_Tickables);
+}
+
+void UEnemyNavPathCache::Tick(float DeltaTime)
+{
+	RepathWindowTime += DeltaTime;
+	if (RepathWindowTime >= 1.f)
+	{
+		SET_FLOAT_STAT(STAT_EnemyNavRepathsPerSecond, RepathsInWindow / RepathWindowTime);
+		RepathsInWindow = 0;
+		RepathWindowTime = 0.f;
+	}
+}
+
+void UEnemyNavPathCache::Flush()
+{
+	Paths.Empty();
+}
+
+void UEnemyNavPathCache::OnNavigationGenerationFinished(ANavigationData* NavData)
+{
+	Flush();
+}
+
+void UEnemyNavPathCache::RecordSuppressedRepath()
+{
+	INC_DWORD_STAT(STAT_EnemyNavRepathsSuppressed);
+}
+
+const ARecastNavMesh* UEnemyNavPathCache::GetNavMesh(const AAIController* Controller) const
+{
+	const UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	return NavSys ? Cast<ARecastNavMesh>(NavSys->GetNavDataForProps(Controller->GetNavAgentPropertiesRef())) : nullptr;
+}
+
+FNavPathSharedPtr UEnemyNavPathCache::MakePathFromCache(const FCachedPath& Cached, AAIController* Controller, const ARecastNavMesh* NavMesh, AActor* Goal) const
+{
+	// every move gets its own path object, path following observes and mutates it
+	TArray<FVector> Points = Cached.Points;
+	Points[0] = Controller->GetNavAgentLocation();
+
+	FNavPathSharedPtr Path = MakeShareable(new FNavigationPath(Points));
+	Path->SetNavigationDataUsed(NavMesh);
+	Path->SetQuerier(Controller);
+	// same tether distance AAIController::FindPathForMoveRequest uses
+	Path->SetGoalActorObservation(*Goal, 100.0f);
+	return Path;
+}
+
+FPathFollowingRequestResult UEnemyNavPathCache::MoveTo(AAIController* Controller, const FAIMoveRequest& MoveRequest, FNavPathSharedPtr* OutPath)
+{
+	AActor* Goal = MoveRequest.GetGoalActor();
+	const ARecastNavMesh* NavMesh = Controller ? GetNavMesh(Controller) : nullptr;
+	if (Goal == nullptr || NavMesh == nullptr || !MoveRequest.IsUsingPathfinding())
+		return Controller ? Controller->MoveTo(MoveRequest, OutPath) : FPathFollowingRequestResult();
+
+	const NavNodeRef StartPoly = NavMesh->FindNearestPoly(Controller->GetNavAgentLocation(), NavMesh->GetDefaultQueryExtent());
+	const FPathKey Key(StartPoly, Goal);
+	const FCachedPath* Cached = StartPoly != INVALID_NAVNODEREF ? Paths.Find(Key) : nullptr;
+
+	if (Cached && FVector::DistSquared(Cached->GoalLocation, Goal->GetActorLocation()) <= FMath::Square(GoalTolerance))
+	{
+		INC_DWORD_STAT(STAT_EnemyNavPathCacheHits);
+		FNavPathSharedPtr Path = MakePathFromCache(*Cached, Controller, NavMesh, Goal);
+
+		FPathFollowingRequestResult Result;
+		Result.MoveId = Controller->RequestMove(MoveRequest, Path);
+		Result.Code = Result.MoveId.IsValid() ? EPathFollowingRequestResult::RequestSuccessful : EPathFollowingRequestResult::Failed;
+		if (OutPath)
+			*OutPath = Path;
+		return Result;
+	}
+
+	INC_DWORD_STAT(STAT_EnemyNavPathCacheMisses);
+	++RepathsInWindow;
+
+	FNavPathSharedPtr Path;
+	const FPathFollowingRequestResult Result = Controller->MoveTo(MoveRequest, &Path);
+	if (StartPoly != INVALID_NAVNODEREF && Path.IsValid() && Path->IsValid() && !Path->IsPartial() && Path->GetPathPoints().Num() > 1)
+	{
+		if (Paths.Num() >= MaxCachedPaths)
+			Flush();
+
+		FCachedPath& NewPath = Paths.Add(Key);
+		NewPath.GoalLocation = Goal->GetActorLocation();
+		NewPath.Points.Reserve(Path->GetPathPoints().Num());
+		for (const FNavPathPoint& Point : Path->GetPathPoints())
+			NewPath.Points.Add(Point.Location);
+	}
+	if (OutPath)
+		*OutPath = Path;
+	return Result;
+}
@@ -0,0 +1,195 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AI/EnemyPerceptionSubsystem.h"
+#include "Rashepur.h"
+#include "Perception/PawnSensingComponent.h"
+#include "GameFramework/Pawn.h"
+#include "Spatial/GameplayTraceScheduler.h"
+
+DECLARE_CYCLE_STAT(TEXT("Enemy Perception Submit"), STAT_EnemyPerceptionSubmit, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sight Requests"), STAT_EnemySightRequests, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sight Culled By Cone"), STAT_EnemySightCulled, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sight Traces Submitted"), STAT_EnemySightTraces, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sight Cache Hits"), STAT_EnemySightCacheHits, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sight Cache Misses"), STAT_EnemySightCacheMisses, STATGROUP_Rashepur);
+
+void UEnemyPerceptionSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	TraceScheduler = Collection.InitializeDependency<UGameplayTraceScheduler>();
+	Super::Initialize(Collection);
+}
+
+void UEnemyPerceptionSubsystem::Deinitialize()
+{
+	TraceScheduler = nullptr;
+	Entries.Empty();
+	EntryIndices.Empty();
+	Super::Deinitialize();
+}
+
+bool UEnemyPerceptionSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UEnemyPerceptionSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UEnemyPerceptionSubsystem, STATGROUP_Tickables);
+}
+
+bool UEnemyPerceptionSubsystem::PassesSightCone(const UPawnSensingComponent* Sensing, const APawn* Target)
+{
+	const FVector SensorToTarget = Target->GetActorLocation() - Sensing->GetSensorLocation();
+	const double DistSquared = SensorToTarget.SizeSquared();
+	if (DistSquared > FMath::Square(Sensing->SightRadius))
+		return false;
+
+	const FVector Facing = Sensing->GetSensorRotation().Vector();
+	return (SensorToTarget.GetSafeNormal() | Facing) >= Sensing->GetPeripheralVisionCosine();
+}
+
+UEnemyPerceptionSubsystem::FSightEntry& UEnemyPerceptionSubsystem::FindOrAddEntry(const AActor* Observer, const APawn* Target)
+{
+	const FSightKey Key(Observer, Target);
+	if (const int32* ExistingIndex = EntryIndices.Find(Key))
+		return Entries[*ExistingIndex];
+
+	// until the first trace lands the pair counts as visible, same as the cone only check did
+	FSightEntry NewEntry;
+	NewEntry.Key = Key;
+	NewEntry.Observer = Observer;
+	NewEntry.Target = Target;
+	const int32 EntryIndex = Entries.Add(NewEntry);
+	EntryIndices.Add(Key, EntryIndex);
+	return Entries[EntryIndex];
+}
+
+bool UEnemyPerceptionSubsystem::IsCacheValid(const FSightEntry& Entry, const UPawnSensingComponent* Sensing, const APawn* Target, double Now) const
+{
+	if (Entry.CacheTime <= 0.0 || Now - Entry.CacheTime > MaxCacheAge)
+		return false;
+	// designers widen the cone while searching, a different cone is a different question
+	if (Entry.PeripheralVisionCosine != Sensing->GetPeripheralVisionCosine() || Entry.SightRadius != Sensing->SightRadius)
+		return false;
+
+	const double ToleranceSquared = FMath::Square(CacheLocationTolerance);
+	return FVector::DistSquared(Entry.SensorLocation, Sensing->GetSensorLocation()) <= ToleranceSquared &&
+		FVector::DistSquared(Entry.TargetLocation, Target->GetActorLocation()) <= ToleranceSquared &&
+		Entry.SensorRotation.Equals(Sensing->GetSensorRotation(), CacheRotationTolerance);
+}
+
+void UEnemyPerceptionSubsystem::Snapshot(FSightEntry& Entry, const UPawnSensingComponent* Sensing, const APawn* Target, double Now) const
+{
+	Entry.SensorLocation = Sensing->GetSensorLocation();
+	Entry.SensorRotation = Sensing->GetSensorRotation();
+	Entry.TargetLocation = Target->GetActorLocation();
+	Entry.PeripheralVisionCosine = Sensing->GetPeripheralVisionCosine();
+	Entry.SightRadius = Sensing->SightRadius;
+	Entry.CacheTime = Now;
+}
+
+bool UEnemyPerceptionSubsystem::CanSee(const UPawnSensingComponent* Sensing, const APawn* Target)
+{
+	if (Sensing == nullptr || Target == nullptr || Sensing->GetOwner() == nullptr) return false;
+
+	INC_DWORD_STAT(STAT_EnemySightRequests);
+	const double Now = GetWorld()->GetTimeSeconds();
+	FSightEntry& Entry = FindOrAddEntry(Sensing->GetOwner(), Target);
+	Entry.LastRequestTime = Now;
+
+	if (IsCacheValid(Entry, Sensing, Target, Now))
+	{
+		INC_DWORD_STAT(STAT_EnemySightCacheHits);
+		return Entry.bInSightCone && Entry.bVisible;
+	}
+
+	INC_DWORD_STAT(STAT_EnemySightCacheMisses);
+	Snapshot(Entry, Sensing, Target, Now);
+	Entry.bInSightCone = PassesSightCone(Sensing, Target);
+	if (!Entry.bInSightCone)
+	{
+		INC_DWORD_STAT(STAT_EnemySightCulled);
+		return false;
+	}
+
+	Entry.bRequested = true;
+	return Entry.bVisible;
+}
+
+void UEnemyPerceptionSubsystem::NotifySeen(const UPawnSensingComponent* Sensing, const APawn* Target)
+{
+	if (Sensing == nullptr || Target == nullptr || Sensing->GetOwner() == nullptr) return;
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	FSightEntry& Entry = FindOrAddEntry(Sensing->GetOwner(), Target);
+	Snapshot(Entry, Sensing, Target, Now);
+	Entry.LastRequestTime = Now;
+	Entry.bInSightCone = true;
+	Entry.bVisible = true;
+	Entry.bRequested = false;
+}
+
+void UEnemyPerceptionSubsystem::Tick(float DeltaTime)
+{
+	SubmitTraces();
+	PruneEntries();
+}
+
+void UEnemyPerceptionSubsystem::SubmitTraces()
+{
+	SCOPE_CYCLE_COUNTER(STAT_EnemyPerceptionSubmit);
+
+	if (TraceScheduler == nullptr) return;
+
+	for (auto It = Entries.CreateIterator(); It; ++It)
+	{
+		FSightEntry& Entry = *It;
+		if (!Entry.bRequested || Entry.bTraceInFlight) continue;
+
+		const AActor* Observer = Entry.Observer.Get();
+		const APawn* Target = Entry.Target.Get();
+		if (Observer == nullptr || Target == nullptr) continue;
+
+		// sight can wait a couple of frames when weapons and targeting fill the batch
+		FGameplayTraceRequest Request;
+		Request.Start = Entry.SensorLocation;
+		Request.End = Target->GetPawnViewLocation();
+		Request.Channel = ECollisionChannel::ECC_Visibility;
+		Request.Params = FCollisionQueryParams(SCENE_QUERY_STAT(EnemySight), true, Observer);
+		Request.Priority = EGameplayTracePriority::Normal;
+		Request.MaxDelayFrames = 2;
+		TraceScheduler->RequestTrace(Request, FOnGameplayTraceCompleted::CreateUObject(this, &UEnemyPerceptionSubsystem::OnTraceCompleted, It.GetIndex()));
+
+		Entry.bRequested = false;
+		Entry.bTraceInFlight = true;
+		INC_DWORD_STAT(STAT_EnemySightTraces);
+	}
+}
+
+void UEnemyPerceptionSubsystem::OnTraceCompleted(const TArray<FHitResult>& Hits, int32 EntryIndex)
+{
+	if (!Entries.IsValidIndex(EntryIndex)) return;
+
+	FSightEntry& Entry = Entries[EntryIndex];
+	const APawn* Target = Entry.Target.Get();
+	const FHitResult* Blocking = Hits.FindByPredicate([](const FHitResult& Hit) { return Hit.bBlockingHit; });
+
+	Entry.bVisible = Blocking == nullptr || (Target && Blocking->GetActor() == Target);
+	Entry.bTraceInFlight = false;
+}
+
+void UEnemyPerceptionSubsystem::PruneEntries()
+{
+	const double Now = GetWorld()->GetTimeSeconds();
+	for (auto It = Entries.CreateIterator(); It; ++It)
+	{
+		// in flight entries stay until their trace lands, the index is bound into the trace's callback
+		const FSightEntry& Entry = *It;
+		if (!Entry.bTraceInFlight && Now - Entry.LastRequestTime > EntryLifetime)
+		{
+			EntryIndices.Remove(Entry.Key);
+			It.RemoveCurrent();
+		}
+	}
+}
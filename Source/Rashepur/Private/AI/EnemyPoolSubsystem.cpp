@@ -0,0 +1,206 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AI/EnemyPoolSubsystem.h"
+#include "Rashepur.h"
+#include "Enemy/Enemy.h"
+#include "EngineUtils.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/AttributeComponent.h"
+#include "Components/CombatStatusComponent.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/DamageType.h"
+#include "Kismet/GameplayStatics.h"
+#include "UObject/UObjectGlobals.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pooled Enemies"), STAT_PooledEnemies, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemies Reused"), STAT_EnemiesReused, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemies Spawned"), STAT_EnemiesSpawned, STATGROUP_Rashepur);
+
+void UEnemyPoolSubsystem::Deinitialize()
+{
+	Buckets.Empty();
+	Super::Deinitialize();
+}
+
+bool UEnemyPoolSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+AEnemy* UEnemyPoolSubsystem::Acquire(TSubclassOf<AEnemy> EnemyClass, const FTransform& Transform, TFunctionRef<void(AEnemy&)> Prepare)
+{
+	if (EnemyClass == nullptr) return nullptr;
+
+	if (FEnemyPoolBucket* Bucket = Buckets.Find(EnemyClass.Get()))
+	{
+		while (Bucket->Enemies.Num() > 0)
+		{
+			AEnemy* Enemy = Bucket->Enemies.Pop(false);
+			if (!IsValid(Enemy)) continue;
+
+			DEC_DWORD_STAT(STAT_PooledEnemies);
+			INC_DWORD_STAT(STAT_EnemiesReused);
+			Enemy->ResetFromPool(Transform);
+			Prepare(*Enemy);
+			Enemy->ActivateEnemy();
+			return Enemy;
+		}
+	}
+
+	AEnemy* Enemy = GetWorld()->SpawnActorDeferred<AEnemy>(EnemyClass, Transform, nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn);
+	if (Enemy == nullptr) return nullptr;
+
+	INC_DWORD_STAT(STAT_EnemiesSpawned);
+	Enemy->AutoPossessAI = EAutoPossessAI::PlacedInWorldOrSpawned;
+	Prepare(*Enemy);
+	Enemy->FinishSpawning(Transform);
+	return Enemy;
+}
+
+AEnemy* UEnemyPoolSubsystem::SpawnEnemy(TSubclassOf<AEnemy> EnemyClass, const FTransform& Transform, const TArray<AActor*>& PatrolTargets, AActor* PatrolTarget)
+{
+	return Acquire(EnemyClass, Transform, [&PatrolTargets, PatrolTarget](AEnemy& Enemy)
+	{
+		Enemy.SetPatrolTargets(PatrolTargets, PatrolTarget);
+	});
+}
+
+void UEnemyPoolSubsystem::Release(AEnemy* Enemy)
+{
+	if (!IsValid(Enemy)) return;
+
+	FEnemyPoolBucket& Bucket = Buckets.FindOrAdd(Enemy->GetClass());
+	if (Bucket.Enemies.Num() >= MaxPooledPerClass)
+	{
+		Enemy->Destroy();
+		return;
+	}
+
+	Enemy->ParkInPool();
+	Bucket.Enemies.Add(Enemy);
+	INC_DWORD_STAT(STAT_PooledEnemies);
+}
+
+int32 UEnemyPoolSubsystem::GetNumPooled() const
+{
+	int32 NumPooled = 0;
+	for (const TPair<TObjectPtr<UClass>, FEnemyPoolBucket>& Bucket : Buckets)
+		NumPooled += Bucket.Value.Enemies.Num();
+	return NumPooled;
+}
+
+#if !UE_BUILD_SHIPPING
+
+/** Whole enemy lives through the pool: acquire, a lethal hit, the death cleanup timer, release and reuse */
+struct FEnemyPoolSoak
+{
+	static bool Fail(int32 Cycle, const TCHAR* Reason)
+	{
+		UE_LOG(LogTemp, Error, TEXT("PoolSoak FAILED at cycle %d: %s"), Cycle, Reason);
+		return false;
+	}
+
+	/** What ResetFromPool has to undo of the last life */
+	static bool CheckReset(const AEnemy& Enemy, int32 Cycle)
+	{
+		const UCapsuleComponent* Capsule = Enemy.GetCapsuleComponent();
+		if (Capsule->GetCollisionEnabled() != Enemy.GetClass()->GetDefaultObject<AEnemy>()->GetCapsuleComponent()->GetCollisionEnabled())
+			return Fail(Cycle, TEXT("capsule collision was not restored"));
+		if (Enemy.Tags.Contains(FName("Dead")))
+			return Fail(Cycle, TEXT("Dead tag survived the reset"));
+		if (UCombatStatusComponent::HasStatus(&Enemy, ECombatStatus::ECST_Dead | ECombatStatus::ECST_Staggered))
+			return Fail(Cycle, TEXT("Dead or Staggered status bit survived the reset"));
+		if (Enemy.EnemyState != EEnemyState::EES_Patrolling || Enemy.AIManagerIndex == INDEX_NONE)
+			return Fail(Cycle, TEXT("enemy did not come back patrolling and registered with the AI manager"));
+		if (Enemy.CharAttributes == nullptr || Enemy.CharAttributes->GetHealth() != Enemy.CharAttributes->GetMaxHealth())
+			return Fail(Cycle, TEXT("health was not refilled"));
+		return true;
+	}
+
+	/** Kills Enemy through damage and Die, then fires the cleanup timer ScheduleDeathCleanup set instead of waiting DeathLifeSpan */
+	static bool KillAndRelease(AEnemy& Enemy, AController* Killer, int32 Cycle)
+	{
+		UGameplayStatics::ApplyDamage(&Enemy, Enemy.CharAttributes->GetMaxHealth(), Killer, Killer->GetPawn(), UDamageType::StaticClass());
+		if (Enemy.IsAlive())
+			return Fail(Cycle, TEXT("a full health hit did not kill"));
+
+		// what a lethal GetHit does, without the hit sound and particles whose transient components would blur the object count
+		Enemy.Die();
+		if (!UCombatStatusComponent::HasStatus(&Enemy, ECombatStatus::ECST_Dead) || !Enemy.Tags.Contains(FName("Dead")))
+			return Fail(Cycle, TEXT("Die did not set the Dead status and tag"));
+		if (Enemy.GetCapsuleComponent()->GetCollisionEnabled() != ECollisionEnabled::NoCollision)
+			return Fail(Cycle, TEXT("Die did not disable the capsule"));
+
+		FTimerManager& TimerManager = Enemy.GetWorldTimerManager();
+		if (!TimerManager.IsTimerActive(Enemy.DeathCleanupTimer))
+			return Fail(Cycle, TEXT("ScheduleDeathCleanup did not schedule the release to the pool"));
+		TimerManager.ClearTimer(Enemy.DeathCleanupTimer);
+		Enemy.ReleaseToPool();
+
+		if (!Enemy.IsHidden() || Enemy.AIManagerIndex != INDEX_NONE)
+			return Fail(Cycle, TEXT("the released enemy was not parked"));
+		return true;
+	}
+
+	static void Run(UWorld* World, int32 NumCycles)
+	{
+		UEnemyPoolSubsystem* Pool = World ? World->GetSubsystem<UEnemyPoolSubsystem>() : nullptr;
+		APlayerController* Killer = World ? World->GetFirstPlayerController() : nullptr;
+		TActorIterator<AEnemy> Template(World);
+		if (Pool == nullptr || !Template || Killer == nullptr || Killer->GetPawn() == nullptr)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("PoolSoak needs a game world with a possessed hero and at least one enemy"));
+			return;
+		}
+
+		const TSubclassOf<AEnemy> EnemyClass = Template->GetClass();
+		const FTransform Transform = Template->GetActorTransform();
+		const TArray<AActor*> NoPatrolTargets;
+
+		// one warm up life so the first spawn and anything created lazily on the first death are not counted
+		AEnemy* Enemy = Pool->SpawnEnemy(EnemyClass, Transform, NoPatrolTargets, nullptr);
+		if (Enemy == nullptr || !KillAndRelease(*Enemy, Killer, 0)) return;
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+		const int32 ObjectsBefore = GUObjectArray.GetObjectArrayNumMinusAvailable();
+
+		const int32 Step = FMath::Max(NumCycles / 10, 1);
+		for (int32 Cycle = 1; Cycle <= NumCycles; ++Cycle)
+		{
+			AEnemy* Reused = Pool->SpawnEnemy(EnemyClass, Transform, NoPatrolTargets, nullptr);
+			if (Reused != Enemy)
+			{
+				Fail(Cycle, TEXT("the parked enemy was not reused"));
+				return;
+			}
+			if (!CheckReset(*Enemy, Cycle) || !KillAndRelease(*Enemy, Killer, Cycle)) return;
+
+			if (Cycle % Step == 0)
+				UE_LOG(LogTemp, Display, TEXT("PoolSoak %6d cycles: %d UObjects (%+d), %d pooled"),
+					Cycle, GUObjectArray.GetObjectArrayNumMinusAvailable(), GUObjectArray.GetObjectArrayNumMinusAvailable() - ObjectsBefore, Pool->GetNumPooled());
+		}
+
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+		const int32 Delta = GUObjectArray.GetObjectArrayNumMinusAvailable() - ObjectsBefore;
+		if (Delta != 0)
+		{
+			UE_LOG(LogTemp, Error, TEXT("PoolSoak FAILED: %+d UObjects after %d lives"), Delta, NumCycles);
+			return;
+		}
+		UE_LOG(LogTemp, Display, TEXT("PoolSoak passed: %d lives, UObject count flat"), NumCycles);
+	}
+};
+
+namespace EnemyPoolSoak
+{
+	static FAutoConsoleCommandWithWorldAndArgs SoakCommand(
+		TEXT("Rashepur.AI.PoolSoak"),
+		TEXT("Rashepur.AI.PoolSoak [Cycles] - kills and respawns an enemy through the pool, checks the reset state and that the UObject count stays flat"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			FEnemyPoolSoak::Run(World, Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 1000);
+		}));
+}
+
+#endif
@@ -0,0 +1,155 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AI/EnemyProxySubsystem.h"
+#include "Rashepur.h"
+#include "AI/EnemyPoolSubsystem.h"
+#include "Enemy/Enemy.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "MassEntitySubsystem.h"
+#include "MassExecutionContext.h"
+
+DECLARE_CYCLE_STAT(TEXT("Enemy Proxy Update"), STAT_EnemyProxyUpdate, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemy Proxies"), STAT_EnemyProxies, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemy Promotions"), STAT_EnemyPromotions, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemy Demotions"), STAT_EnemyDemotions, STATGROUP_Rashepur);
+
+void UEnemyProxySubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Collection.InitializeDependency<UMassEntitySubsystem>();
+	Super::Initialize(Collection);
+
+	ProxyQuery.AddRequirement<FEnemyProxyFragment>(EMassFragmentAccess::ReadOnly);
+	if (FMassEntityManager* EntityManager = GetEntityManager())
+		ProxyArchetype = EntityManager->CreateArchetype(TConstArrayView<const UScriptStruct*>({ FEnemyProxyFragment::StaticStruct() }));
+}
+
+void UEnemyProxySubsystem::Deinitialize()
+{
+	Enemies.Empty();
+	PendingPromotions.Empty();
+	Super::Deinitialize();
+}
+
+bool UEnemyProxySubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UEnemyProxySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UEnemyProxySubsystem, STATGROUP_Tickables);
+}
+
+FMassEntityManager* UEnemyProxySubsystem::GetEntityManager() const
+{
+	UMassEntitySubsystem* MassSubsystem = GetWorld()->GetSubsystem<UMassEntitySubsystem>();
+	return MassSubsystem ? &MassSubsystem->GetMutableEntityManager() : nullptr;
+}
+
+void UEnemyProxySubsystem::RegisterEnemy(AEnemy* Enemy)
+{
+	if (Enemy)
+		Enemies.AddUnique(Enemy);
+}
+
+void UEnemyProxySubsystem::UnregisterEnemy(AEnemy* Enemy)
+{
+	Enemies.RemoveSingleSwap(Enemy, false);
+}
+
+void UEnemyProxySubsystem::Tick(float DeltaTime)
+{
+	UpdateTimer += DeltaTime;
+	if (UpdateTimer < UpdateInterval) return;
+	UpdateTimer = 0.f;
+
+	SCOPE_CYCLE_COUNTER(STAT_EnemyProxyUpdate);
+
+	const APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	const APawn* Hero = PlayerController ? PlayerController->GetPawn() : nullptr;
+	if (Hero == nullptr || !ProxyArchetype.IsValid()) return;
+
+	const FVector HeroLocation = Hero->GetActorLocation();
+	DemoteDistantEnemies(HeroLocation);
+	PromoteNearbyProxies(HeroLocation);
+}
+
+void UEnemyProxySubsystem::DemoteDistantEnemies(const FVector& HeroLocation)
+{
+	const double DemotionRadiusSquared = FMath::Square((double)DemotionRadius);
+	for (int32 Index = Enemies.Num() - 1; Index >= 0; --Index)
+	{
+		// Demote destroys the actor, whose EndPlay swaps it out of Enemies, so walk backwards
+		AEnemy* Enemy = Enemies[Index];
+		if (Enemy && Enemy->CanBeDemoted() &&
+			FVector::DistSquared(Enemy->GetActorLocation(), HeroLocation) > DemotionRadiusSquared &&
+			!Enemy->GetMesh()->WasRecentlyRendered(DemotionUnrenderedTime))
+		{
+			Demote(Enemy);
+		}
+	}
+}
+
+void UEnemyProxySubsystem::PromoteNearbyProxies(const FVector& HeroLocation)
+{
+	FMassEntityManager* EntityManager = GetEntityManager();
+	if (EntityManager == nullptr) return;
+
+	// spawning and destroying entities is not allowed while the query walks the chunks
+	const double PromotionRadiusSquared = FMath::Square((double)PromotionRadius);
+	PendingPromotions.Reset();
+	FMassExecutionContext Context(*EntityManager);
+	ProxyQuery.ForEachEntityChunk(*EntityManager, Context, [this, &HeroLocation, PromotionRadiusSquared](FMassExecutionContext& ChunkContext)
+	{
+		const TConstArrayView<FEnemyProxyFragment> Proxies = ChunkContext.GetFragmentView<FEnemyProxyFragment>();
+		for (int32 Index = 0; Index < ChunkContext.GetNumEntities(); ++Index)
+		{
+			if (FVector::DistSquared(Proxies[Index].Transform.GetLocation(), HeroLocation) <= PromotionRadiusSquared)
+				PendingPromotions.Add(ChunkContext.GetEntity(Index));
+		}
+	});
+
+	for (const FMassEntityHandle Entity : PendingPromotions)
+	{
+		if (Promote(EntityManager->GetFragmentDataChecked<FEnemyProxyFragment>(Entity)))
+		{
+			EntityManager->DestroyEntity(Entity);
+			INC_DWORD_STAT(STAT_EnemyPromotions);
+			DEC_DWORD_STAT(STAT_EnemyProxies);
+		}
+	}
+}
+
+void UEnemyProxySubsystem::Demote(AEnemy* Enemy)
+{
+	FMassEntityManager* EntityManager = GetEntityManager();
+	if (EntityManager == nullptr) return;
+
+	const FMassEntityHandle Entity = EntityManager->CreateEntity(ProxyArchetype);
+	Enemy->CaptureProxyState(EntityManager->GetFragmentDataChecked<FEnemyProxyFragment>(Entity));
+	if (UEnemyPoolSubsystem* Pool = GetWorld()->GetSubsystem<UEnemyPoolSubsystem>())
+		Pool->Release(Enemy);
+	else
+		Enemy->Destroy();
+	INC_DWORD_STAT(STAT_EnemyDemotions);
+	INC_DWORD_STAT(STAT_EnemyProxies);
+}
+
+AEnemy* UEnemyProxySubsystem::Promote(const FEnemyProxyFragment& Proxy)
+{
+	UClass* EnemyClass = Proxy.EnemyClass.Get();
+	if (EnemyClass == nullptr) return nullptr;
+
+	if (UEnemyPoolSubsystem* Pool = GetWorld()->GetSubsystem<UEnemyPoolSubsystem>())
+		return Pool->Acquire(EnemyClass, Proxy.Transform, [&Proxy](AEnemy& Enemy) { Enemy.RestoreProxyState(Proxy); });
+
+	AEnemy* Enemy = GetWorld()->SpawnActorDeferred<AEnemy>(EnemyClass, Proxy.Transform, nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn);
+	if (Enemy == nullptr) return nullptr;
+
+	// restored before BeginPlay so InitializeEnemy sees the patrol state and the controller is there to use it
+	Enemy->AutoPossessAI = EAutoPossessAI::PlacedInWorldOrSpawned;
+	Enemy->RestoreProxyState(Proxy);
+	Enemy->FinishSpawning(Proxy.Transform);
+	return Enemy;
+}
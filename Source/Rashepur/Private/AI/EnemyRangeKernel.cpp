@@ -0,0 +1,222 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AI/EnemyRangeKernel.h"
+#include "AI/EnemyAITypes.h"
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "HAL/IConsoleManager.h"
+
+namespace EnemyRangeKernel
+{
+	using EnemyDecisionCore::MaskByTargets;
+
+	void ComputeRangeFlagsScalar(const FEnemyRangeKernelInput& Input, TArrayView<uint8> Flags, int32 StartIndex)
+	{
+		const int32 NumEnemies = Input.Num();
+		for (int32 Index = StartIndex; Index < NumEnemies; ++Index)
+		{
+			const float TargetDX = Input.TargetX[Index] - Input.EnemyX[Index];
+			const float TargetDY = Input.TargetY[Index] - Input.EnemyY[Index];
+			const float TargetDZ = Input.TargetZ[Index] - Input.EnemyZ[Index];
+			const float TargetDistSquared = TargetDX * TargetDX + TargetDY * TargetDY + TargetDZ * TargetDZ;
+
+			const float PatrolDX = Input.PatrolX[Index] - Input.EnemyX[Index];
+			const float PatrolDY = Input.PatrolY[Index] - Input.EnemyY[Index];
+			const float PatrolDZ = Input.PatrolZ[Index] - Input.EnemyZ[Index];
+			const float PatrolDistSquared = PatrolDX * PatrolDX + PatrolDY * PatrolDY + PatrolDZ * PatrolDZ;
+
+			Flags[Index] |= EnemyDecisionCore::RangeBits(Flags[Index], TargetDistSquared, PatrolDistSquared,
+				Input.CombatRadiusSquared[Index], Input.AttackRadiusSquared[Index], Input.PatrolRadiusSquared[Index]);
+		}
+	}
+
+	FORCEINLINE VectorRegister4Float DistSquared4(const float* AX, const float* AY, const float* AZ, const float* BX, const float* BY, const float* BZ)
+	{
+		const VectorRegister4Float DX = VectorSubtract(VectorLoad(BX), VectorLoad(AX));
+		const VectorRegister4Float DY = VectorSubtract(VectorLoad(BY), VectorLoad(AY));
+		const VectorRegister4Float DZ = VectorSubtract(VectorLoad(BZ), VectorLoad(AZ));
+		return VectorMultiplyAdd(DZ, DZ, VectorMultiplyAdd(DY, DY, VectorMultiply(DX, DX)));
+	}
+
+	void ComputeRangeFlags(const FEnemyRangeKernelInput& Input, TArrayView<uint8> Flags)
+	{
+		const int32 NumEnemies = Input.Num();
+		const int32 NumVectorized = NumEnemies & ~3;
+
+		for (int32 Index = 0; Index < NumVectorized; Index += 4)
+		{
+			const VectorRegister4Float TargetDistSquared = DistSquared4(
+				&Input.EnemyX[Index], &Input.EnemyY[Index], &Input.EnemyZ[Index],
+				&Input.TargetX[Index], &Input.TargetY[Index], &Input.TargetZ[Index]);
+			const VectorRegister4Float PatrolDistSquared = DistSquared4(
+				&Input.EnemyX[Index], &Input.EnemyY[Index], &Input.EnemyZ[Index],
+				&Input.PatrolX[Index], &Input.PatrolY[Index], &Input.PatrolZ[Index]);
+
+			// one bit per lane for each band
+			const int32 CombatBits = VectorMaskBits(VectorCompareLE(TargetDistSquared, VectorLoad(&Input.CombatRadiusSquared[Index])));
+			const int32 AttackBits = VectorMaskBits(VectorCompareLE(TargetDistSquared, VectorLoad(&Input.AttackRadiusSquared[Index])));
+			const int32 PatrolBits = VectorMaskBits(VectorCompareLE(PatrolDistSquared, VectorLoad(&Input.PatrolRadiusSquared[Index])));
+
+			for (int32 Lane = 0; Lane < 4; ++Lane)
+			{
+				const uint8 BandBits =
+					(((CombatBits >> Lane) & 1) ? EnemyAIFlags::InCombatRadius : 0) |
+					(((AttackBits >> Lane) & 1) ? EnemyAIFlags::InAttackRadius : 0) |
+					(((PatrolBits >> Lane) & 1) ? EnemyAIFlags::InPatrolRadius : 0);
+				Flags[Index + Lane] |= MaskByTargets(Flags[Index + Lane], BandBits);
+			}
+		}
+
+		ComputeRangeFlagsScalar(Input, Flags, NumVectorized);
+	}
+}
+
+#if !UE_BUILD_SHIPPING
+
+namespace EnemyRangeKernelBenchmark
+{
+	/** What AEnemy::CheckCombatTarget used to do: one sqrt distance per InTargetRange call, for the same pair every time */
+	static bool InTargetRange(const FVector& Location, const FVector& Target, double Radius)
+	{
+		return (Target - Location).Size() <= Radius;
+	}
+
+	static void Run(int32 NumEnemies, int32 Iterations)
+	{
+		FRandomStream Random(NumEnemies);
+		TArray<FVector> Locations, Targets, PatrolLocations;
+		TArray<float> EnemyX, EnemyY, EnemyZ, TargetX, TargetY, TargetZ, PatrolX, PatrolY, PatrolZ;
+		TArray<float> CombatRadiusSquared, AttackRadiusSquared, PatrolRadiusSquared;
+		TArray<uint8> Flags;
+		for (int32 Index = 0; Index < NumEnemies; ++Index)
+		{
+			const FVector Location(Random.FRandRange(-50000.f, 50000.f), Random.FRandRange(-50000.f, 50000.f), 0.f);
+			const FVector Target = Location + Random.VRand() * Random.FRandRange(0.f, 2000.f);
+			const FVector Patrol = Location + Random.VRand() * Random.FRandRange(0.f, 400.f);
+			Locations.Add(Location); Targets.Add(Target); PatrolLocations.Add(Patrol);
+			EnemyX.Add(Location.X); EnemyY.Add(Location.Y); EnemyZ.Add(Location.Z);
+			TargetX.Add(Target.X); TargetY.Add(Target.Y); TargetZ.Add(Target.Z);
+			PatrolX.Add(Patrol.X); PatrolY.Add(Patrol.Y); PatrolZ.Add(Patrol.Z);
+			CombatRadiusSquared.Add(FMath::Square(1000.f));
+			AttackRadiusSquared.Add(FMath::Square(190.f));
+			PatrolRadiusSquared.Add(FMath::Square(200.f));
+			Flags.Add(0);
+		}
+
+		int32 ScalarHits = 0;
+		const double ScalarStart = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			for (int32 Index = 0; Index < NumEnemies; ++Index)
+			{
+				const bool bOutsideCombat = !InTargetRange(Locations[Index], Targets[Index], 1000.0);
+				const bool bCanChase = InTargetRange(Locations[Index], Targets[Index], 1000.0) && !InTargetRange(Locations[Index], Targets[Index], 190.0);
+				const bool bCanSearch = InTargetRange(Locations[Index], Targets[Index], 1000.0);
+				const bool bCanEngage = InTargetRange(Locations[Index], Targets[Index], 190.0);
+				const bool bArrived = InTargetRange(Locations[Index], PatrolLocations[Index], 200.0);
+				ScalarHits += bOutsideCombat + bCanChase + bCanSearch + bCanEngage + bArrived;
+			}
+		}
+		const double ScalarSeconds = FPlatformTime::Seconds() - ScalarStart;
+
+		const FEnemyRangeKernelInput Input{ EnemyX, EnemyY, EnemyZ, TargetX, TargetY, TargetZ, PatrolX, PatrolY, PatrolZ,
+			CombatRadiusSquared, AttackRadiusSquared, PatrolRadiusSquared };
+		int32 KernelHits = 0;
+		const double KernelStart = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			for (uint8& EnemyFlags : Flags)
+				EnemyFlags = EnemyAIFlags::HasCombatTarget | EnemyAIFlags::HasPatrolTarget;
+			EnemyRangeKernel::ComputeRangeFlags(Input, Flags);
+			KernelHits += (Flags[Iteration % NumEnemies] & EnemyAIFlags::InCombatRadius) != 0;
+		}
+		const double KernelSeconds = FPlatformTime::Seconds() - KernelStart;
+
+		const double Evaluations = (double)NumEnemies * Iterations;
+		UE_LOG(LogTemp, Display, TEXT("RangeKernel %6d enemies: scalar %8.2f ns/enemy, kernel %8.2f ns/enemy, speedup %.1fx (checksum %d)"),
+			NumEnemies,
+			ScalarSeconds * 1e9 / Evaluations,
+			KernelSeconds * 1e9 / Evaluations,
+			ScalarSeconds / FMath::Max(KernelSeconds, UE_SMALL_NUMBER),
+			ScalarHits + KernelHits);
+	}
+
+	/** The manager's range and decision passes over 1 to 64 chunks, for how far they scale with the worker threads of this machine */
+	static void RunChunkSweep(int32 NumEnemies, int32 Iterations)
+	{
+		FRandomStream Random(NumEnemies);
+		TArray<float> EnemyX, EnemyY, EnemyZ, TargetX, TargetY, TargetZ, PatrolX, PatrolY, PatrolZ;
+		TArray<float> CombatRadiusSquared, AttackRadiusSquared, PatrolRadiusSquared;
+		TArray<uint8> GatheredFlags, States, Actions, Flags;
+		TArray<EnemyDecisionCore::EDecision> Decisions;
+		for (int32 Index = 0; Index < NumEnemies; ++Index)
+		{
+			const FVector Location(Random.FRandRange(-50000.f, 50000.f), Random.FRandRange(-50000.f, 50000.f), 0.f);
+			const FVector Target = Location + Random.VRand() * Random.FRandRange(0.f, 2000.f);
+			const FVector Patrol = Location + Random.VRand() * Random.FRandRange(0.f, 400.f);
+			EnemyX.Add(Location.X); EnemyY.Add(Location.Y); EnemyZ.Add(Location.Z);
+			TargetX.Add(Target.X); TargetY.Add(Target.Y); TargetZ.Add(Target.Z);
+			PatrolX.Add(Patrol.X); PatrolY.Add(Patrol.Y); PatrolZ.Add(Patrol.Z);
+			CombatRadiusSquared.Add(FMath::Square(1000.f));
+			AttackRadiusSquared.Add(FMath::Square(190.f));
+			PatrolRadiusSquared.Add(FMath::Square(200.f));
+			GatheredFlags.Add((uint8)(EnemyAIFlags::DecisionDue | EnemyAIFlags::HasCombatTarget | EnemyAIFlags::HasPatrolTarget | (Random.RandHelper(2) ? EnemyAIFlags::CanSeeTarget : 0)));
+			States.Add((uint8)Random.RandHelper((int32)EnemyDecisionCore::EState::NoState + 1));
+			Actions.Add((uint8)Random.RandHelper((int32)EnemyDecisionCore::EAction::Attacking + 1));
+		}
+		Flags.SetNumZeroed(NumEnemies);
+		Decisions.SetNumZeroed(NumEnemies);
+
+		UE_LOG(LogTemp, Display, TEXT("Decide passes %6d enemies, %d worker threads:"), NumEnemies, FTaskGraphInterface::Get().GetNumWorkerThreads());
+		double SingleChunkSeconds = 0.0;
+		for (int32 NumChunks = 1; NumChunks <= 64; NumChunks *= 2)
+		{
+			// the same rounding as UEnemyAIManager::ForEachActiveChunk
+			const int32 ChunkSize = Align(FMath::DivideAndRoundUp(NumEnemies, NumChunks), 4);
+			const int32 NumTasks = FMath::DivideAndRoundUp(NumEnemies, ChunkSize);
+			const double Start = FPlatformTime::Seconds();
+			for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+			{
+				ParallelFor(NumTasks, [&, ChunkSize](int32 Chunk)
+				{
+					const int32 ChunkStart = Chunk * ChunkSize;
+					const int32 Count = FMath::Min(ChunkSize, NumEnemies - ChunkStart);
+					const FEnemyRangeKernelInput Input{
+						MakeArrayView(EnemyX.GetData() + ChunkStart, Count), MakeArrayView(EnemyY.GetData() + ChunkStart, Count), MakeArrayView(EnemyZ.GetData() + ChunkStart, Count),
+						MakeArrayView(TargetX.GetData() + ChunkStart, Count), MakeArrayView(TargetY.GetData() + ChunkStart, Count), MakeArrayView(TargetZ.GetData() + ChunkStart, Count),
+						MakeArrayView(PatrolX.GetData() + ChunkStart, Count), MakeArrayView(PatrolY.GetData() + ChunkStart, Count), MakeArrayView(PatrolZ.GetData() + ChunkStart, Count),
+						MakeArrayView(CombatRadiusSquared.GetData() + ChunkStart, Count), MakeArrayView(AttackRadiusSquared.GetData() + ChunkStart, Count), MakeArrayView(PatrolRadiusSquared.GetData() + ChunkStart, Count) };
+					FMemory::Memcpy(Flags.GetData() + ChunkStart, GatheredFlags.GetData() + ChunkStart, Count);
+					EnemyRangeKernel::ComputeRangeFlags(Input, MakeArrayView(Flags.GetData() + ChunkStart, Count));
+					for (int32 Index = ChunkStart; Index < ChunkStart + Count; ++Index)
+						Decisions[Index] = EnemyDecisionCore::Decide((EnemyDecisionCore::EState)States[Index], (EnemyDecisionCore::EAction)Actions[Index], Flags[Index]);
+				}, NumTasks > 1 ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread);
+			}
+			const double Seconds = FPlatformTime::Seconds() - Start;
+			if (NumChunks == 1)
+				SingleChunkSeconds = Seconds;
+
+			UE_LOG(LogTemp, Display, TEXT("  %2d chunks of %6d: %8.2f ns/enemy, %8.1f us/frame, speedup %.2fx (decision %d)"),
+				NumTasks, ChunkSize,
+				Seconds * 1e9 / ((double)NumEnemies * Iterations),
+				Seconds * 1e6 / Iterations,
+				SingleChunkSeconds / FMath::Max(Seconds, UE_SMALL_NUMBER),
+				(int32)Decisions[Iterations % NumEnemies]);
+		}
+	}
+
+	static FAutoConsoleCommand BenchCommand(
+		TEXT("Rashepur.AI.BenchRangeKernel"),
+		TEXT("Compares the SIMD enemy range kernel with the per call sqrt distance path at 100, 1k and 10k enemies, then times the range and decision passes over 1 to 64 parallel chunks at 10k and 100k enemies"),
+		FConsoleCommandDelegate::CreateLambda([]()
+		{
+			Run(100, 20000);
+			Run(1000, 2000);
+			Run(10000, 200);
+			RunChunkSweep(10000, 200);
+			RunChunkSweep(100000, 20);
+		}));
+}
+
+#endif
@@ -0,0 +1,141 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AI/PatrolRouteSubsystem.h"
+#include "Rashepur.h"
+#include "AIController.h"
+#include "NavigationSystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Patrol Route Bake"), STAT_PatrolRouteBake, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Patrol Routes"), STAT_PatrolRoutes, STATGROUP_Rashepur);
+
+int32 FPatrolRouteGraph::IndexOf(const AActor* Point) const
+{
+	for (int32 Index = 0; Index < Points.Num(); ++Index)
+		if (Points[Index].Get() == Point)
+			return Index;
+	return INDEX_NONE;
+}
+
+int32 FPatrolRouteGraph::PairIndex(int32 A, int32 B) const
+{
+	// row A of the upper triangle starts after the A rows above it
+	return A * Num() - A * (A + 1) / 2 + (B - A - 1);
+}
+
+bool FPatrolRouteGraph::GetPath(int32 From, int32 To, TArray<FNavPathPoint>& OutPoints) const
+{
+	if (From == To || !Points.IsValidIndex(From) || !Points.IsValidIndex(To)) return false;
+
+	const int32 Pair = PairIndex(FMath::Min(From, To), FMath::Max(From, To));
+	if (!PathOffsets.IsValidIndex(Pair + 1)) return false;
+	const int32 Begin = PathOffsets[Pair];
+	const int32 End = PathOffsets[Pair + 1];
+	if (End - Begin < 2) return false;
+
+	OutPoints.Reset(End - Begin);
+	if (From < To)
+	{
+		for (int32 Index = Begin; Index < End; ++Index)
+			OutPoints.Add(FNavPathPoint(PathPoints[Index]));
+	}
+	else
+	{
+		for (int32 Index = End - 1; Index >= Begin; --Index)
+			OutPoints.Add(FNavPathPoint(PathPoints[Index]));
+	}
+	return true;
+}
+
+void UPatrolRouteSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+	if (UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(&InWorld))
+		NavSys->OnNavigationGenerationFinishedDelegate.AddDynamic(this, &UPatrolRouteSubsystem::OnNavigationGenerationFinished);
+}
+
+void UPatrolRouteSubsystem::Deinitialize()
+{
+	if (UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld()))
+		NavSys->OnNavigationGenerationFinishedDelegate.RemoveDynamic(this, &UPatrolRouteSubsystem::OnNavigationGenerationFinished);
+	Routes.Empty();
+	Super::Deinitialize();
+}
+
+bool UPatrolRouteSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TSharedPtr<const FPatrolRouteGraph> UPatrolRouteSubsystem::FindOrBakeRoute(const TArray<AActor*>& PatrolTargets, const AAIController* Controller)
+{
+	// only runs at BeginPlay, the point set is normalized once so equal sets compare equal
+	TArray<AActor*> Points;
+	for (AActor* Point : PatrolTargets)
+		if (Point)
+			Points.AddUnique(Point);
+	if (Points.Num() == 0) return nullptr;
+	Points.Sort([](const AActor& A, const AActor& B) { return A.GetUniqueID() < B.GetUniqueID(); });
+
+	const UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	const ANavigationData* NavData = NavSys && Controller ? NavSys->GetNavDataForProps(Controller->GetNavAgentPropertiesRef()) : nullptr;
+
+	for (const TSharedPtr<FPatrolRouteGraph>& Route : Routes)
+	{
+		if (Route->NavData.Get() != NavData || Route->Num() != Points.Num()) continue;
+
+		bool bSamePoints = true;
+		for (int32 Index = 0; Index < Points.Num() && bSamePoints; ++Index)
+			bSamePoints = Route->Points[Index].Get() == Points[Index];
+		if (bSamePoints)
+			return Route;
+	}
+
+	TSharedPtr<FPatrolRouteGraph> Route = MakeShared<FPatrolRouteGraph>();
+	Route->Points.Append(Points);
+	Route->NavData = NavData;
+	Bake(*Route);
+	Routes.Add(Route);
+	SET_DWORD_STAT(STAT_PatrolRoutes, Routes.Num());
+	return Route;
+}
+
+void UPatrolRouteSubsystem::Bake(FPatrolRouteGraph& Route) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_PatrolRouteBake);
+
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	const ANavigationData* NavData = Route.NavData.Get();
+	const int32 NumPoints = Route.Num();
+
+	Route.PathPoints.Reset();
+	Route.PathOffsets.Reset(NumPoints * (NumPoints - 1) / 2 + 1);
+	for (int32 A = 0; A < NumPoints; ++A)
+	for (int32 B = A + 1; B < NumPoints; ++B)
+	{
+		Route.PathOffsets.Add(Route.PathPoints.Num());
+
+		const AActor* From = Route.Points[A].Get();
+		const AActor* To = Route.Points[B].Get();
+		if (NavSys == nullptr || NavData == nullptr || From == nullptr || To == nullptr) continue;
+
+		// partial paths are left out, patrolling falls back to a regular MoveTo for those pairs
+		const FPathFindingQuery Query(this, *NavData, From->GetActorLocation(), To->GetActorLocation());
+		const FPathFindingResult Result = NavSys->FindPathSync(Query);
+		if (Result.IsSuccessful() && !Result.IsPartial() && Result.Path.IsValid())
+		{
+			for (const FNavPathPoint& Point : Result.Path->GetPathPoints())
+				Route.PathPoints.Add(Point.Location);
+		}
+	}
+	Route.PathOffsets.Add(Route.PathPoints.Num());
+
+	UE_LOG(LogTemp, Verbose, TEXT("Baked patrol route with %d points, %d path points"), NumPoints, Route.PathPoints.Num());
+}
+
+void UPatrolRouteSubsystem::OnNavigationGenerationFinished(ANavigationData* NavData)
+{
+	for (const TSharedPtr<FPatrolRouteGraph>& Route : Routes)
+		if (Route->NavData.Get() == NavData)
+			Bake(*Route);
+}
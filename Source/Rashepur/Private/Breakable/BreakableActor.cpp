@@ -5,6 +5,7 @@
 #include "GeometryCollection/GeometryCollectionComponent.h"
 #include "Components/CapsuleComponent.h"
 #include "Treasure.h"
+#include "Spatial/SpatialHashSubsystem.h"
 
 ABreakableActor::ABreakableActor()
 {
@@ -27,6 +28,8 @@ void ABreakableActor::BeginPlay()
 {
 	Super::BeginPlay();
 	GeometryCollection->OnChaosBreakEvent.AddDynamic(this, &ABreakableActor::OnFinishedBreaking);
+	if (USpatialHashSubsystem* SpatialHash = GetWorld()->GetSubsystem<USpatialHashSubsystem>())
+		SpatialHash->Register(this, ESpatialCategory::Breakable);
 }
 
 void ABreakableActor::OnFinishedBreaking(const FChaosBreakEvent& BreakEvent)
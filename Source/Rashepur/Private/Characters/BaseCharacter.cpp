@@ -4,11 +4,17 @@
 #include "Characters/BaseCharacter.h"
 #include "Components/BoxComponent.h"
 #include "Components/AttributeComponent.h"
+#include "Components/CombatStatusComponent.h"
 #include "Components/CapsuleComponent.h"
+#include "GameFramework/CharacterMovementComponent.h"
 #include "Perception/PawnSensingComponent.h"
 #include "Kismet/GameplayStatics.h"
 #include "Rashepur/Weapons/Weapon.h"
 #include "Navigation/PathFollowingComponent.h"
+#include "Characters/CharacterStateTransitions.h"
+#include "Characters/MontageSectionRegistry.h"
+#include "Animation/AnimInstance.h"
+#include "UObject/ObjectKey.h"
 
 
 ABaseCharacter::ABaseCharacter()
@@ -16,6 +22,7 @@ ABaseCharacter::ABaseCharacter()
 	PrimaryActorTick.bCanEverTick = true;
 	// Class default components setup
 	CharAttributes = CreateDefaultSubobject<UAttributeComponent>(TEXT("CharAttributes"));
+	CombatStatus = CreateDefaultSubobject<UCombatStatusComponent>(TEXT("CombatStatus"));
 	
 	GetCapsuleComponent()->SetCollisionResponseToChannel(ECollisionChannel::ECC_Camera, ECollisionResponse::ECR_Ignore);
 
@@ -30,7 +37,41 @@ ABaseCharacter::ABaseCharacter()
 void ABaseCharacter::BeginPlay()
 {
 	Super::BeginPlay();
-	
+	RegisterMontageSections();
+}
+
+void ABaseCharacter::PublishAnimSnapshot(FCharacterAnimSnapshot& OutSnapshot) const
+{
+	const UCharacterMovementComponent* Movement = GetCharacterMovement();
+	OutSnapshot.GroundSpeed = Movement ? Movement->Velocity.Size2D() : 0.f;
+	OutSnapshot.bIsFalling = Movement && Movement->IsFalling();
+	OutSnapshot.CharacterState = CharacterState;
+}
+
+void CharacterAnim::WarnIfGameThreadOnly(const UAnimInstance* AnimInstance)
+{
+#if !UE_BUILD_SHIPPING
+	// the switch is "Use Multi Threaded Animation Update" in the anim blueprint's class settings, it lives in the .uasset
+	static TSet<TObjectKey<UClass>> WarnedClasses;
+	if (AnimInstance == nullptr || AnimInstance->CanRunParallelWork()) return;
+
+	bool bAlreadyWarned = false;
+	WarnedClasses.Add(AnimInstance->GetClass(), &bAlreadyWarned);
+	if (!bAlreadyWarned)
+		UE_LOG(LogTemp, Warning, TEXT("%s updates on the game thread, enable Use Multi Threaded Animation Update in its class settings"), *AnimInstance->GetClass()->GetName());
+#endif
+}
+
+void ABaseCharacter::RegisterMontageSections()
+{
+	if (UMontageSectionRegistry* Registry = UMontageSectionRegistry::Find(GetWorld()))
+	{
+		for (const UAnimMontage* Montage : { AttackMontage1H, AttackMontage2H, HitReactMontage, DeathMontage, SearchMontage })
+		{
+			if (Montage)
+				Registry->Register(Montage);
+		}
+	}
 }
 
 void ABaseCharacter::GetHit_Implementation(const FVector& ImpactPoint, AActor* Hitter)
@@ -46,25 +87,28 @@ void ABaseCharacter::GetHit_Implementation(const FVector& ImpactPoint, AActor* H
 
 void ABaseCharacter::Attack()
 {
-	ActionState = EActionState::EAS_Attacking;
-	if (bDebugStates)
-		UE_LOG(LogTemp, Warning, TEXT("ActionState set to EAS_Attacking BaseCharacter (Attack)"));
+	SetActionState(EActionState::EAS_Attacking);
+	RASHEPUR_STATE_LOG(bDebugStates, Warning, TEXT("ActionState set to EAS_Attacking BaseCharacter (Attack)"));
 	PlayAttackMontage();
 }
 
 bool ABaseCharacter::IsCombatTargetDead()
 {
-	if (CombatTarget)
-		return CombatTarget->ActorHasTag(FName("Dead"));
-	else
-		return false;
+	return UCombatStatusComponent::HasStatus(CombatTarget, ECombatStatus::ECST_Dead);
 }
 
 void ABaseCharacter::Die()
 {
 	DisableCapsule();
 	SelectDeathMontage();
+	CombatStatus->SetStatus(ECombatStatus::ECST_Dead, true);
+	// kept for Blueprints, C++ checks the status bits
 	Tags.Add(FName("Dead"));
+	ScheduleDeathCleanup();
+}
+
+void ABaseCharacter::ScheduleDeathCleanup()
+{
 	SetLifeSpan(DeathLifeSpan);
 }
 
@@ -74,10 +118,14 @@ void ABaseCharacter::MoveTo(AActor* Target, bool DrawDebugSpheresOnPath)
 }
 
 FName ABaseCharacter::GetWeaponSocket(AWeapon* Weapon)
+{
+	return GetWeaponSocket(Weapon->GetWeaponType());
+}
+
+FName ABaseCharacter::GetWeaponSocket(EWeaponType WeaponType) const
 {
 	FName WeaponSocket = FName("OneHandedSocket");
 
-	EWeaponType WeaponType = Weapon->GetWeaponType();
 	switch (WeaponType)
 	{
 	case EWeaponType::EWT_TwoHand:
@@ -101,9 +149,9 @@ FName ABaseCharacter::GetWeaponSpineSocket(AWeapon* OverlappingWeapon)
 
 void ABaseCharacter::SetCharacterStateByWeaponType()
 {
-	if (EquippedWeapon)
+	if (const TOptional<EWeaponType> WeaponType = GetHeldWeaponType())
 	{
-		switch (EquippedWeapon->GetWeaponType())
+		switch (WeaponType.GetValue())
 		{
 		case EWeaponType::EWT_OneHand:
 			CharacterState = ECharacterState::ECS_EquippedOneHandedWeapon;
@@ -156,7 +204,7 @@ FVector ABaseCharacter::GetRotationWarpTarget()
 
 void ABaseCharacter::PlaySearchMontage()
 {
-	PlayMontageSection(SearchMontage, FName("LookAround"), 1.f);
+	PlayMontageSection(SearchMontage, GetMontageSection(SearchMontage, EMontageSection::LookAround), 1.f);
 }
 
 float ABaseCharacter::GetSearchMontageLength()
@@ -166,9 +214,9 @@ float ABaseCharacter::GetSearchMontageLength()
 	return 0.0f;
 }
 
-UAnimInstance* ABaseCharacter::PlayHitReactMontage(const FName& SectionName)
+UAnimInstance* ABaseCharacter::PlayHitReactMontage(EMontageSection Section)
 {
-	return PlayMontageSection(HitReactMontage, SectionName, 1.f, false);
+	return PlayMontageSection(HitReactMontage, GetMontageSection(HitReactMontage, Section), 1.f, false);
 }
 
 UAnimInstance* ABaseCharacter::DirectionalHitReact(const FVector& ImpactPoint)
@@ -195,13 +243,13 @@ UAnimInstance* ABaseCharacter::DirectionalHitReact(const FVector& ImpactPoint)
 	{
 		Theta *= -1.f;
 	}
-	FName Section("FromBack");
+	EMontageSection Section = EMontageSection::FromBack;
 	if (Theta > -45.f && Theta < 45.f)
-		Section = FName("FromFront");
+		Section = EMontageSection::FromFront;
 	else if (Theta >= -135.f && Theta < -45.f)
-		Section = FName("FromLeft");
+		Section = EMontageSection::FromLeft;
 	else if (Theta >= 45.f && Theta < 135.f)
-		Section = FName("FromRight");
+		Section = EMontageSection::FromRight;
 	return PlayHitReactMontage(Section);
 }
 
@@ -226,13 +274,12 @@ void ABaseCharacter::ResetPeripheralVision()
 		PawnSensing->SetPeripheralVisionAngle(DefaultPeripheralVision);
 }
 
-UAnimInstance* ABaseCharacter::PlayMontageSection(UAnimMontage* Montage, const FName& SectionName, float AnimationSpeed, bool SetEndDelegate)
+UAnimInstance* ABaseCharacter::PlayMontageSection(UAnimMontage* Montage, const FMontageSectionRef& Section, float AnimationSpeed, bool SetEndDelegate)
 {
 	UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
 	if (AnimInstance && Montage)
 	{
-		AnimInstance->Montage_Play(Montage, AnimationSpeed);
-		AnimInstance->Montage_JumpToSection(SectionName, Montage);
+		AnimInstance->Montage_Play(Montage, AnimationSpeed, EMontagePlayReturnType::MontageLength, Section.StartTime);
 		if (SetEndDelegate)
 			AnimInstance->Montage_SetEndDelegate(EndMontageDelegate);
 		return AnimInstance;
@@ -248,15 +295,16 @@ void ABaseCharacter::StopAnimMontage(UAnimMontage* Montage)
 	}
 }
 
-FName ABaseCharacter::RandomMontageSection(UAnimMontage* Montage, FString MontagePrefix)
+FMontageSectionRef ABaseCharacter::GetMontageSection(const UAnimMontage* Montage, EMontageSection Section) const
 {
-	FName SectionName;
-	if (Montage)
-	{
-		int32 Selection = FMath::RandRange(1, Montage->GetNumSections());
-		SectionName = FName(MontagePrefix + FString::FromInt(Selection));
-	}
-	return SectionName;
+	UMontageSectionRegistry* Registry = UMontageSectionRegistry::Find(GetWorld());
+	return Montage && Registry ? Registry->GetSection(Montage, Section) : FMontageSectionRef();
+}
+
+FMontageSectionRef ABaseCharacter::RandomAttackSection(const UAnimMontage* Montage) const
+{
+	UMontageSectionRegistry* Registry = UMontageSectionRegistry::Find(GetWorld());
+	return Montage && Registry ? Registry->RandomAttack(Montage) : FMontageSectionRef();
 }
 
 void ABaseCharacter::PlayAttackMontage()
@@ -264,16 +312,15 @@ void ABaseCharacter::PlayAttackMontage()
 	UAnimMontage* EquippedWeaponMontage = GetAttackMontageByWeaponType();
 	if (EquippedWeaponMontage)
 	{		
-		PlayMontageSection(EquippedWeaponMontage, RandomMontageSection(EquippedWeaponMontage, FString("Attack")), AttackAnimationSpeed);
+		PlayMontageSection(EquippedWeaponMontage, RandomAttackSection(EquippedWeaponMontage), AttackAnimationSpeed);
 	}
 }
 
 UAnimMontage* ABaseCharacter::GetAttackMontageByWeaponType()
 {
-	if (EquippedWeapon)
+	if (const TOptional<EWeaponType> WeaponType = GetHeldWeaponType())
 	{
-		EWeaponType WeaponType = EquippedWeapon->GetWeaponType();
-		switch (WeaponType)
+		switch (WeaponType.GetValue())
 		{
 			case EWeaponType::EWT_OneHand:
 				return AttackMontage1H;
@@ -290,9 +337,18 @@ UAnimMontage* ABaseCharacter::GetAttackMontageByWeaponType()
 
 void ABaseCharacter::OnActionEnded(UAnimMontage* Montage, bool bInterrupted)
 {
-	ActionState = EActionState::EAS_Unoccupied;
-	if (bDebugStates)
-		UE_LOG(LogTemp, Warning, TEXT("ActionState set to EAS_Unoccupied BaseCharacter (onactionended)"));
+	SetActionState(EActionState::EAS_Unoccupied);
+	RASHEPUR_STATE_LOG(bDebugStates, Warning, TEXT("ActionState set to EAS_Unoccupied BaseCharacter (onactionended)"));
+}
+
+void ABaseCharacter::SetActionState(EActionState NewState)
+{
+#if RASHEPUR_WITH_STATE_STATS
+	ensureMsgf(CharacterStateTransitions::IsLegal(ActionState, NewState), TEXT("%s: illegal action state change %s -> %s"),
+		*GetName(), *UEnum::GetValueAsString(ActionState), *UEnum::GetValueAsString(NewState));
+	CharacterStateTransitions::RecordTransition(ActionState, NewState);
+#endif
+	ActionState = NewState;
 }
 
 bool ABaseCharacter::CanAttack()
@@ -335,6 +391,11 @@ void ABaseCharacter::Tick(float DeltaTime)
 	Super::Tick(DeltaTime);
 }
 
+TOptional<EWeaponType> ABaseCharacter::GetHeldWeaponType() const
+{
+	return EquippedWeapon ? TOptional<EWeaponType>(EquippedWeapon->GetWeaponType()) : TOptional<EWeaponType>();
+}
+
 void ABaseCharacter::SetWeaponCollisionEnabled(ECollisionEnabled::Type CollisionEnabled)
 {
 	if (EquippedWeapon)
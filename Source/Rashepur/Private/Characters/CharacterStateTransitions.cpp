@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Characters/CharacterStateTransitions.h"
+#include "HAL/IConsoleManager.h"
+
+#if RASHEPUR_WITH_STATE_STATS
+
+namespace CharacterStateTransitions
+{
+	static uint32 EnemyStateEdgeCounts[NumEnemyStates * NumEnemyStates] = {};
+	static uint32 ActionStateEdgeCounts[NumActionStates * NumActionStates] = {};
+
+	void RecordTransition(EEnemyState From, EEnemyState To)
+	{
+		++EnemyStateEdgeCounts[(int32)From * NumEnemyStates + (int32)To];
+	}
+
+	void RecordTransition(EActionState From, EActionState To)
+	{
+		++ActionStateEdgeCounts[(int32)From * NumActionStates + (int32)To];
+	}
+
+	template<typename EnumType>
+	static void DumpEdges(const uint32* Counts, int32 NumStates)
+	{
+		for (int32 From = 0; From < NumStates; ++From)
+		for (int32 To = 0; To < NumStates; ++To)
+		{
+			const uint32 Count = Counts[From * NumStates + To];
+			if (Count > 0)
+			{
+				UE_LOG(LogTemp, Display, TEXT("%-28s -> %-28s %u"),
+					*UEnum::GetValueAsString((EnumType)From), *UEnum::GetValueAsString((EnumType)To), Count);
+			}
+		}
+	}
+
+	static FAutoConsoleCommand DumpCommand(
+		TEXT("Rashepur.States.DumpTransitions"),
+		TEXT("Logs how often every enemy and action state transition happened since the last reset"),
+		FConsoleCommandDelegate::CreateLambda([]()
+		{
+			DumpEdges<EEnemyState>(EnemyStateEdgeCounts, NumEnemyStates);
+			DumpEdges<EActionState>(ActionStateEdgeCounts, NumActionStates);
+		}));
+
+	static FAutoConsoleCommand ResetCommand(
+		TEXT("Rashepur.States.ResetTransitions"),
+		TEXT("Clears the state transition counters"),
+		FConsoleCommandDelegate::CreateLambda([]()
+		{
+			FMemory::Memzero(EnemyStateEdgeCounts);
+			FMemory::Memzero(ActionStateEdgeCounts);
+		}));
+}
+
+#endif
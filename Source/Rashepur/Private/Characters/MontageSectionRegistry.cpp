@@ -0,0 +1,100 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Characters/MontageSectionRegistry.h"
+#include "Animation/AnimMontage.h"
+#include "Engine/World.h"
+#include "UObject/UObjectGlobals.h"
+
+namespace MontageSectionNames
+{
+	/** In EMontageSection order */
+	static const TCHAR* const Named[(int32)EMontageSection::MAX] =
+	{
+		TEXT("FromFront"),
+		TEXT("FromBack"),
+		TEXT("FromLeft"),
+		TEXT("FromRight"),
+		TEXT("LookAround"),
+		TEXT("Equip"),
+		TEXT("Unequip"),
+	};
+
+	static const TCHAR* const AttackPrefix = TEXT("Attack");
+}
+
+void UMontageSectionRegistry::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+#if WITH_EDITOR
+	ObjectPropertyChangedHandle = FCoreUObjectDelegates::OnObjectPropertyChanged.AddUObject(this, &UMontageSectionRegistry::OnObjectPropertyChanged);
+#endif
+}
+
+void UMontageSectionRegistry::Deinitialize()
+{
+#if WITH_EDITOR
+	FCoreUObjectDelegates::OnObjectPropertyChanged.Remove(ObjectPropertyChangedHandle);
+#endif
+	Tables.Empty();
+	Super::Deinitialize();
+}
+
+bool UMontageSectionRegistry::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+UMontageSectionRegistry* UMontageSectionRegistry::Find(const UWorld* World)
+{
+	return World ? World->GetSubsystem<UMontageSectionRegistry>() : nullptr;
+}
+
+void UMontageSectionRegistry::Register(const UAnimMontage* Montage)
+{
+	FindOrResolve(Montage);
+}
+
+FMontageSectionRef UMontageSectionRegistry::RandomAttack(const UAnimMontage* Montage)
+{
+	const TArray<FMontageSectionRef>& Attacks = FindOrResolve(Montage).Attacks;
+	return Attacks.Num() > 0 ? Attacks[FMath::RandRange(0, Attacks.Num() - 1)] : FMontageSectionRef();
+}
+
+#if WITH_EDITOR
+void UMontageSectionRegistry::OnObjectPropertyChanged(UObject* Object, FPropertyChangedEvent& PropertyChangedEvent)
+{
+	// sections added, renamed or moved in the montage editor during PIE
+	if (const UAnimMontage* Montage = Cast<UAnimMontage>(Object))
+		Tables.Remove(Montage);
+}
+#endif
+
+FMontageSectionTable UMontageSectionRegistry::Resolve(const UAnimMontage* Montage)
+{
+	FMontageSectionTable Table;
+	if (Montage == nullptr) return Table;
+
+	auto MakeRef = [Montage](int32 Index)
+	{
+		FMontageSectionRef Ref;
+		if (Index == INDEX_NONE) return Ref;
+		float EndTime = 0.f;
+		Ref.Index = Index;
+		Montage->GetSectionStartAndEndTime(Index, Ref.StartTime, EndTime);
+		return Ref;
+	};
+
+	Table.NumSections = Montage->GetNumSections();
+	for (int32 Section = 0; Section < (int32)EMontageSection::MAX; ++Section)
+		Table.Named[Section] = MakeRef(Montage->GetSectionIndex(MontageSectionNames::Named[Section]));
+
+	// the variants are numbered from 1 without gaps, stop at the first missing one
+	for (int32 Variant = 1; Variant <= Table.NumSections; ++Variant)
+	{
+		const int32 Index = Montage->GetSectionIndex(*FString::Printf(TEXT("%s%d"), MontageSectionNames::AttackPrefix, Variant));
+		if (Index == INDEX_NONE) break;
+		Table.Attacks.Add(MakeRef(Index));
+	}
+	return Table;
+}
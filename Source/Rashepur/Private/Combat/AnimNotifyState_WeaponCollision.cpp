@@ -0,0 +1,20 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Combat/AnimNotifyState_WeaponCollision.h"
+#include "Characters/BaseCharacter.h"
+#include "Components/SkeletalMeshComponent.h"
+
+void UAnimNotifyState_WeaponCollision::NotifyBegin(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation, float TotalDuration, const FAnimNotifyEventReference& EventReference)
+{
+	Super::NotifyBegin(MeshComp, Animation, TotalDuration, EventReference);
+	if (ABaseCharacter* Character = MeshComp ? Cast<ABaseCharacter>(MeshComp->GetOwner()) : nullptr)
+		Character->SetWeaponCollisionEnabled(ECollisionEnabled::QueryOnly);
+}
+
+void UAnimNotifyState_WeaponCollision::NotifyEnd(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation, const FAnimNotifyEventReference& EventReference)
+{
+	if (ABaseCharacter* Character = MeshComp ? Cast<ABaseCharacter>(MeshComp->GetOwner()) : nullptr)
+		Character->SetWeaponCollisionEnabled(ECollisionEnabled::NoCollision);
+	Super::NotifyEnd(MeshComp, Animation, EventReference);
+}
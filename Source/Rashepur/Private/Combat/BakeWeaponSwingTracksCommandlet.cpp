@@ -0,0 +1,205 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Combat/BakeWeaponSwingTracksCommandlet.h"
+#include "Combat/WeaponSwingTrack.h"
+#include "Combat/AnimNotifyState_WeaponCollision.h"
+#include "Characters/BaseCharacter.h"
+#include "Animation/AnimMontage.h"
+#include "Animation/AnimSequence.h"
+#include "Engine/SkeletalMesh.h"
+#include "Engine/SkeletalMeshSocket.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "UObject/Package.h"
+#include "UObject/SavePackage.h"
+#include "Misc/PackageName.h"
+
+UBakeWeaponSwingTracksCommandlet::UBakeWeaponSwingTracksCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UBakeWeaponSwingTracksCommandlet::Main(const FString& Params)
+{
+#if WITH_EDITOR
+	FString CharacterPath;
+	if (!FParse::Value(*Params, TEXT("Character="), CharacterPath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("BakeWeaponSwingTracks: missing -Character=/Game/Path/BP_Character"));
+		return 1;
+	}
+
+	FString SocketList = TEXT("OneHandedSocket,TwoHandedSocket,DualHandSocket");
+	FParse::Value(*Params, TEXT("Sockets="), SocketList, false);
+	TArray<FString> SocketNames;
+	SocketList.ParseIntoArray(SocketNames, TEXT(","));
+	for (const FString& SocketName : SocketNames)
+		Sockets.Add(FName(*SocketName));
+
+	FString NotifyName;
+	if (FParse::Value(*Params, TEXT("EnableNotify="), NotifyName))
+		EnableNotify = FName(*NotifyName);
+	if (FParse::Value(*Params, TEXT("DisableNotify="), NotifyName))
+		DisableNotify = FName(*NotifyName);
+	FParse::Value(*Params, TEXT("SampleRate="), SampleRate);
+	SampleRate = FMath::Max(SampleRate, 1.f);
+
+	// a Blueprint path names the generated class as Path.Name_C
+	if (!CharacterPath.Contains(TEXT(".")))
+		CharacterPath += TEXT(".") + FPackageName::GetShortName(CharacterPath) + TEXT("_C");
+	UClass* CharacterClass = StaticLoadClass(ABaseCharacter::StaticClass(), nullptr, *CharacterPath);
+	const ABaseCharacter* Character = CharacterClass ? CharacterClass->GetDefaultObject<ABaseCharacter>() : nullptr;
+	USkeletalMesh* Mesh = Character ? Character->GetMesh()->GetSkeletalMeshAsset() : nullptr;
+	if (Mesh == nullptr)
+	{
+		UE_LOG(LogTemp, Error, TEXT("BakeWeaponSwingTracks: %s is not a character with a skeletal mesh"), *CharacterPath);
+		return 1;
+	}
+
+	const FTransform MeshToActor = Character->GetMesh()->GetRelativeTransform();
+	int32 NumBaked = 0;
+	for (UAnimMontage* Montage : { Character->AttackMontage1H, Character->AttackMontage2H })
+	{
+		if (Montage == nullptr) continue;
+
+		const FString TrackName = Montage->GetName() + TEXT("_SwingTrack");
+		const FString PackageName = FPackageName::GetLongPackagePath(Montage->GetOutermost()->GetName()) / TrackName;
+		UPackage* Package = CreatePackage(*PackageName);
+		UWeaponSwingTrack* Track = NewObject<UWeaponSwingTrack>(Package, *TrackName, RF_Public | RF_Standalone);
+		Track->Montage = Montage;
+
+		if (BakeMontage(Montage, Mesh, MeshToActor, *Track) && SaveTrack(Track))
+			++NumBaked;
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("BakeWeaponSwingTracks: baked %d swing tracks for %s"), NumBaked, *CharacterPath);
+	return NumBaked > 0 ? 0 : 1;
+#else
+	return 1;
+#endif
+}
+
+#if WITH_EDITOR
+
+bool UBakeWeaponSwingTracksCommandlet::BakeMontage(UAnimMontage* Montage, USkeletalMesh* Mesh, const FTransform& MeshToActor, UWeaponSwingTrack& Track) const
+{
+	for (int32 SectionIndex = 0; SectionIndex < Montage->CompositeSections.Num(); ++SectionIndex)
+	{
+		const FName SectionName = Montage->CompositeSections[SectionIndex].SectionName;
+		if (!SectionName.ToString().StartsWith(TEXT("Attack"))) continue;
+
+		float SectionStart = 0.f;
+		float SectionEnd = 0.f;
+		Montage->GetSectionStartAndEndTime(SectionIndex, SectionStart, SectionEnd);
+		float WindowStart = 0.f;
+		float WindowEnd = 0.f;
+		if (!FindActiveWindow(Montage, SectionStart, SectionEnd, WindowStart, WindowEnd))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("BakeWeaponSwingTracks: %s %s has no active damage window, skipped"), *Montage->GetName(), *SectionName.ToString());
+			continue;
+		}
+
+		for (const FName Socket : Sockets)
+		{
+			if (Mesh->FindSocket(Socket) == nullptr) continue;
+
+			FWeaponSwingSection& Swing = Track.Sections.AddDefaulted_GetRef();
+			Swing.Section = SectionName;
+			Swing.Socket = Socket;
+			Swing.ActiveStart = WindowStart - SectionStart;
+			Swing.ActiveEnd = WindowEnd - SectionStart;
+			Swing.SampleInterval = 1.f / SampleRate;
+
+			// one sample past the end so Sample can interpolate up to ActiveEnd
+			const int32 NumSamples = FMath::CeilToInt32((WindowEnd - WindowStart) * SampleRate) + 1;
+			for (int32 Sample = 0; Sample < NumSamples; ++Sample)
+			{
+				const float MontageTime = FMath::Min(WindowStart + Sample * Swing.SampleInterval, SectionEnd);
+				FTransform ComponentSpace;
+				if (!SampleSocket(Montage, Mesh, Socket, MontageTime, ComponentSpace)) break;
+
+				const FTransform ActorSpace = ComponentSpace * MeshToActor;
+				Swing.Locations.Add(FVector3f(ActorSpace.GetLocation()));
+				Swing.Rotations.Add(FQuat4f(ActorSpace.GetRotation()));
+			}
+		}
+	}
+	return Track.Sections.Num() > 0;
+}
+
+bool UBakeWeaponSwingTracksCommandlet::FindActiveWindow(const UAnimMontage* Montage, float SectionStart, float SectionEnd, float& OutStart, float& OutEnd) const
+{
+	OutStart = SectionEnd;
+	OutEnd = SectionStart;
+	float PendingEnable = -1.f;
+	for (const FAnimNotifyEvent& Notify : Montage->Notifies)
+	{
+		const float Begin = Notify.GetTriggerTime();
+		if (Begin < SectionStart || Begin >= SectionEnd) continue;
+
+		if (Notify.NotifyStateClass && Notify.NotifyStateClass->IsA<UAnimNotifyState_WeaponCollision>())
+		{
+			OutStart = FMath::Min(OutStart, Begin);
+			OutEnd = FMath::Max(OutEnd, FMath::Min(Notify.GetEndTriggerTime(), SectionEnd));
+		}
+		else if (!EnableNotify.IsNone() && Notify.NotifyName == EnableNotify)
+			PendingEnable = Begin;
+		else if (!DisableNotify.IsNone() && Notify.NotifyName == DisableNotify && PendingEnable >= 0.f)
+		{
+			OutStart = FMath::Min(OutStart, PendingEnable);
+			OutEnd = FMath::Max(OutEnd, Begin);
+			PendingEnable = -1.f;
+		}
+	}
+	// several windows in one section are baked as one span from the first start to the last end
+	return OutEnd > OutStart;
+}
+
+bool UBakeWeaponSwingTracksCommandlet::SampleSocket(const UAnimMontage* Montage, USkeletalMesh* Mesh, FName Socket, float MontageTime, FTransform& OutComponentSpace) const
+{
+	if (Montage->SlotAnimTracks.Num() == 0) return false;
+
+	const FAnimSegment* Segment = Montage->SlotAnimTracks[0].AnimTrack.GetSegmentAtTime(MontageTime);
+	const UAnimSequence* Sequence = Segment ? Cast<UAnimSequence>(Segment->GetAnimReference()) : nullptr;
+	const USkeletalMeshSocket* MeshSocket = Mesh->FindSocket(Socket);
+	if (Sequence == nullptr || MeshSocket == nullptr) return false;
+
+	const FReferenceSkeleton& RefSkeleton = Mesh->GetRefSkeleton();
+	const float SequenceTime = Segment->ConvertTrackPosToAnimPos(MontageTime);
+
+	// the root is skipped for root motion montages, the actor follows it so in actor space it stays put
+	const int32 StopAt = Montage->HasRootMotion() ? 0 : INDEX_NONE;
+	FTransform ComponentSpace = MeshSocket->GetSocketLocalTransform();
+	for (int32 BoneIndex = RefSkeleton.FindBoneIndex(MeshSocket->BoneName); BoneIndex != INDEX_NONE && BoneIndex != StopAt; BoneIndex = RefSkeleton.GetParentIndex(BoneIndex))
+	{
+		const int32 SkeletonBoneIndex = Sequence->GetSkeleton()->GetSkeletonBoneIndexFromMeshBoneIndex(Mesh, BoneIndex);
+		FTransform BoneLocal = RefSkeleton.GetRefBonePose()[BoneIndex];
+		if (SkeletonBoneIndex != INDEX_NONE)
+			Sequence->GetBoneTransform(BoneLocal, FSkeletonPoseBoneIndex(SkeletonBoneIndex), SequenceTime, false);
+		ComponentSpace = ComponentSpace * BoneLocal;
+	}
+	OutComponentSpace = ComponentSpace;
+	return true;
+}
+
+bool UBakeWeaponSwingTracksCommandlet::SaveTrack(UWeaponSwingTrack* Track) const
+{
+	UPackage* Package = Track->GetOutermost();
+	Package->MarkPackageDirty();
+	const FString Filename = FPackageName::LongPackageNameToFilename(Package->GetName(), FPackageName::GetAssetPackageExtension());
+
+	FSavePackageArgs SaveArgs;
+	SaveArgs.TopLevelFlags = RF_Public | RF_Standalone;
+	if (!UPackage::SavePackage(Package, Track, *Filename, SaveArgs))
+	{
+		UE_LOG(LogTemp, Error, TEXT("BakeWeaponSwingTracks: could not save %s"), *Filename);
+		return false;
+	}
+	UE_LOG(LogTemp, Display, TEXT("BakeWeaponSwingTracks: %s, %d sections"), *Package->GetName(), Track->Sections.Num());
+	return true;
+}
+
+#endif
@@ -0,0 +1,111 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Combat/DamageResolutionSubsystem.h"
+#include "Rashepur.h"
+#include "Kismet/GameplayStatics.h"
+#include "Interfaces/HitInterface.h"
+#include "GameFramework/Controller.h"
+#include "Algo/StableSort.h"
+
+DECLARE_CYCLE_STAT(TEXT("Damage Resolution"), STAT_DamageResolution, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Raw Hits"), STAT_RawHits, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Resolved Hits"), STAT_ResolvedHits, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Hit Victims"), STAT_HitVictims, STATGROUP_Rashepur);
+
+void UDamageResolutionSubsystem::Deinitialize()
+{
+	QueuedHits.Empty();
+	QueuedHitIndices.Empty();
+	ResolvingHits.Empty();
+	Super::Deinitialize();
+}
+
+bool UDamageResolutionSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UDamageResolutionSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UDamageResolutionSubsystem, STATGROUP_Tickables);
+}
+
+void UDamageResolutionSubsystem::QueueHit(const FHitResult& Hit, float Damage, AController* EventInstigator, AActor* DamageCauser, AActor* Hitter, uint32 SwingId, FOnHitResolved OnResolved)
+{
+	AActor* Victim = Hit.GetActor();
+	if (Victim == nullptr) return;
+	INC_DWORD_STAT(STAT_RawHits);
+
+	const FHitKey Key(Hitter, Victim, SwingId);
+	if (const int32* ExistingIndex = QueuedHitIndices.Find(Key))
+	{
+		// the other hand or another sub-step of the same swing, only the strongest counts
+		FQueuedHit& Existing = QueuedHits[*ExistingIndex];
+		if (Damage > Existing.Damage)
+		{
+			Existing.Hit = Hit;
+			Existing.Damage = Damage;
+			Existing.OnResolved = MoveTemp(OnResolved);
+		}
+		return;
+	}
+
+	QueuedHitIndices.Add(Key, QueuedHits.Num());
+	FQueuedHit& Queued = QueuedHits.AddDefaulted_GetRef();
+	Queued.Hit = Hit;
+	Queued.Victim = Victim;
+	Queued.Hitter = Hitter;
+	Queued.DamageCauser = DamageCauser;
+	Queued.EventInstigator = EventInstigator;
+	Queued.OnResolved = MoveTemp(OnResolved);
+	Queued.Damage = Damage;
+}
+
+void UDamageResolutionSubsystem::Tick(float DeltaTime)
+{
+	ResolveHits();
+}
+
+void UDamageResolutionSubsystem::ResolveHits()
+{
+	if (QueuedHits.Num() == 0) return;
+	SCOPE_CYCLE_COUNTER(STAT_DamageResolution);
+
+	Swap(QueuedHits, ResolvingHits);
+	QueuedHitIndices.Reset();
+	INC_DWORD_STAT_BY(STAT_ResolvedHits, ResolvingHits.Num());
+
+	// every victim's hits next to each other, in the order they arrived
+	Algo::StableSortBy(ResolvingHits, [](const FQueuedHit& Queued) { return Queued.Victim.Get(); });
+
+	int32 GroupStart = 0;
+	for (int32 Index = 1; Index <= ResolvingHits.Num(); ++Index)
+	{
+		if (Index == ResolvingHits.Num() || ResolvingHits[Index].Victim != ResolvingHits[GroupStart].Victim)
+		{
+			ResolveVictim(TArrayView<FQueuedHit>(ResolvingHits.GetData() + GroupStart, Index - GroupStart));
+			GroupStart = Index;
+		}
+	}
+	ResolvingHits.Reset();
+}
+
+void UDamageResolutionSubsystem::ResolveVictim(TArrayView<FQueuedHit> VictimHits)
+{
+	AActor* Victim = VictimHits[0].Victim.Get();
+	if (Victim == nullptr) return;
+	INC_DWORD_STAT(STAT_HitVictims);
+
+	FQueuedHit* Strongest = &VictimHits[0];
+	for (FQueuedHit& Queued : VictimHits)
+	{
+		UGameplayStatics::ApplyDamage(Victim, Queued.Damage, Queued.EventInstigator.Get(), Queued.DamageCauser.Get(), UDamageType::StaticClass());
+		if (Queued.Damage > Strongest->Damage)
+			Strongest = &Queued;
+	}
+
+	// one reaction per victim, from the hit that did the most
+	IHitInterface::DispatchGetHit(Victim, Strongest->Hit.ImpactPoint, Strongest->Hitter.Get());
+	Strongest->OnResolved.ExecuteIfBound(Strongest->Hit);
+}
@@ -0,0 +1,27 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Combat/WeaponSwingTrack.h"
+
+FTransform FWeaponSwingSection::Sample(float SectionTime) const
+{
+	const int32 LastSample = Locations.Num() - 1;
+	if (LastSample < 0) return FTransform::Identity;
+
+	const float SamplePosition = FMath::Clamp((SectionTime - ActiveStart) / SampleInterval, 0.f, (float)LastSample);
+	const int32 Index = FMath::Min((int32)SamplePosition, LastSample);
+	const int32 Next = FMath::Min(Index + 1, LastSample);
+	const float Alpha = SamplePosition - Index;
+
+	const FVector Location = (FVector)FMath::Lerp(Locations[Index], Locations[Next], Alpha);
+	const FQuat Rotation = (FQuat)FQuat4f::Slerp(Rotations[Index], Rotations[Next], Alpha);
+	return FTransform(Rotation, Location);
+}
+
+const FWeaponSwingSection* UWeaponSwingTrack::FindSection(FName Section, FName Socket) const
+{
+	return Sections.FindByPredicate([Section, Socket](const FWeaponSwingSection& Swing)
+	{
+		return Swing.Section == Section && Swing.Socket == Socket;
+	});
+}
@@ -28,6 +28,11 @@ float UAttributeComponent::GetHealthPercent()
     return Health / MaxHealth;
 }
 
+void UAttributeComponent::SetHealth(float NewHealth)
+{
+	Health = FMath::Clamp(NewHealth, 0.f, MaxHealth);
+}
+
 bool UAttributeComponent::isAlive()
 {
     return Health > 0;
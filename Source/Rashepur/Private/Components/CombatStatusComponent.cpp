@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Components/CombatStatusComponent.h"
+#include "Characters/BaseCharacter.h"
+
+UCombatStatusComponent::UCombatStatusComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+}
+
+const UCombatStatusComponent* UCombatStatusComponent::Find(const AActor* Actor)
+{
+	if (Actor == nullptr) return nullptr;
+	if (const ABaseCharacter* Character = Cast<ABaseCharacter>(Actor))
+		return Character->GetCombatStatus();
+	return Actor->FindComponentByClass<UCombatStatusComponent>();
+}
+
+ECombatFaction UCombatStatusComponent::GetFaction(const AActor* Actor)
+{
+	const UCombatStatusComponent* CombatStatus = Find(Actor);
+	return CombatStatus ? CombatStatus->Faction : ECombatFaction::ECF_Neutral;
+}
+
+bool UCombatStatusComponent::HasStatus(const AActor* Actor, ECombatStatus InStatus)
+{
+	const UCombatStatusComponent* CombatStatus = Find(Actor);
+	return CombatStatus && CombatStatus->HasStatus(InStatus);
+}
+
+ECombatAttitude UCombatStatusComponent::GetAttitude(const AActor* From, const AActor* To)
+{
+	return CombatAttitude::Get(GetFaction(From), GetFaction(To));
+}
+
+bool UCombatStatusComponent::CanDamage(const AActor* From, const AActor* To)
+{
+	if (To == nullptr) return false;
+
+	const UCombatStatusComponent* ToStatus = Find(To);
+	const ECombatFaction ToFaction = ToStatus ? ToStatus->Faction : ECombatFaction::ECF_Neutral;
+	if (CombatAttitude::Get(GetFaction(From), ToFaction) == ECombatAttitude::ECA_Friendly) return false;
+	return ToStatus == nullptr || !ToStatus->HasStatus(ECombatStatus::ECST_Invulnerable);
+}
+
+void UCombatStatusComponent::SetStatus(ECombatStatus InStatus, bool bSet)
+{
+	if (bSet)
+		EnumAddFlags(Status, InStatus);
+	else
+		EnumRemoveFlags(Status, InStatus);
+}
+
+void UCombatStatusComponent::SetFaction(ECombatFaction NewFaction)
+{
+	Faction = NewFaction;
+}
@@ -0,0 +1,251 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Components/WeaponLoadoutComponent.h"
+#include "Components/BoxComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Kismet/GameplayStatics.h"
+#include "GameFramework/Character.h"
+#include "Animation/AnimInstance.h"
+#include "Animation/AnimMontage.h"
+#include "Combat/WeaponSwingTrack.h"
+#include "Rashepur/Weapons/Weapon.h"
+#include "Rashepur/Weapons/WeaponHitbox.h"
+
+UWeaponLoadoutComponent::UWeaponLoadoutComponent()
+{
+	// ticks only while a tracked swing is active
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+}
+
+void UWeaponLoadoutComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	TickSwings();
+}
+
+void UWeaponLoadoutComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	Unequip();
+	Super::EndPlay(EndPlayReason);
+}
+
+void UWeaponLoadoutComponent::Equip(TSubclassOf<AWeapon> WeaponClass, USceneComponent* Parent, FName MainSocket, FName OffHandSocket)
+{
+	Unequip();
+	const AWeapon* WeaponDefaults = WeaponClass ? WeaponClass->GetDefaultObject<AWeapon>() : nullptr;
+	if (WeaponDefaults == nullptr || Parent == nullptr) return;
+
+	WeaponType = WeaponDefaults->GetWeaponType();
+	TraceExtent = WeaponDefaults->GetBoxTraceExtent();
+	Damage = WeaponDefaults->GetDamage();
+	bShowTraceDebug = WeaponDefaults->ShowsBoxDebug();
+	bUseSwingTracking = WeaponDefaults->UsesSwingTracking();
+	// swings sample the blades after the hands have been animated this frame
+	AddTickPrerequisiteComponent(Parent);
+
+	AddHeldWeapon(WeaponDefaults, Parent, MainSocket);
+	if (WeaponType == EWeaponType::EWT_BothHands)
+		AddHeldWeapon(WeaponDefaults, Parent, OffHandSocket);
+
+	if (USoundBase* EquipSound = WeaponDefaults->GetEquipWeaponSound())
+		UGameplayStatics::PlaySoundAtLocation(this, EquipSound, Parent->GetComponentLocation());
+}
+
+void UWeaponLoadoutComponent::AddHeldWeapon(const AWeapon* WeaponDefaults, USceneComponent* Parent, FName Socket)
+{
+	AActor* Owner = GetOwner();
+	const UStaticMeshComponent* MeshDefaults = WeaponDefaults->GetItemMesh();
+	const UBoxComponent* BoxDefaults = WeaponDefaults->GetWeaponBox();
+
+	FHeldWeapon& Held = HeldWeapons.AddDefaulted_GetRef();
+	Held.Mesh = NewObject<UStaticMeshComponent>(Owner);
+	Held.Mesh->SetStaticMesh(MeshDefaults->GetStaticMesh());
+	Held.Mesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Held.Mesh->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
+	Held.Socket = Socket;
+	Held.Mesh->SetupAttachment(Parent, Socket);
+	Held.Mesh->RegisterComponent();
+
+	Held.Box = NewObject<UBoxComponent>(Owner);
+	Held.Box->SetBoxExtent(BoxDefaults->GetUnscaledBoxExtent());
+	Held.Box->SetRelativeTransform(BoxDefaults->GetRelativeTransform());
+	Held.Box->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Held.Box->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
+	Held.Box->SetupAttachment(Held.Mesh);
+	Held.Box->RegisterComponent();
+	Held.Box->OnComponentBeginOverlap.AddDynamic(this, &UWeaponLoadoutComponent::OnBoxOverlap);
+
+	Held.TraceStart = WeaponDefaults->GetBoxTraceStart()->GetRelativeTransform();
+	Held.TraceEnd = WeaponDefaults->GetBoxTraceEnd()->GetRelativeLocation();
+	Held.Swing.MaxStepDistance = WeaponDefaults->GetSwingMaxStepDistance();
+	Held.Swing.MaxSubSteps = WeaponDefaults->GetSwingMaxSubSteps();
+	Held.Swing.bShowDebug = WeaponDefaults->ShowsBoxDebug();
+}
+
+void UWeaponLoadoutComponent::Unequip()
+{
+	for (FHeldWeapon& Held : HeldWeapons)
+	{
+		if (Held.Box)
+			Held.Box->DestroyComponent();
+		if (Held.Mesh)
+			Held.Mesh->DestroyComponent();
+	}
+	HeldWeapons.Empty();
+	IgnoreActors.Empty();
+	SetComponentTickEnabled(false);
+}
+
+void UWeaponLoadoutComponent::SetWeaponCollisionEnabled(ECollisionEnabled::Type CollisionEnabled)
+{
+	const bool bEnabled = CollisionEnabled != ECollisionEnabled::NoCollision;
+	IgnoreActors.Empty();
+	SwingHitActors.Reset();
+	if (bEnabled)
+		SwingId = WeaponHitbox::NewSwingId();
+
+	if (!bUseSwingTracking)
+	{
+		for (const FHeldWeapon& Held : HeldWeapons)
+			SetBoxCollisionEnabled(Held, bEnabled);
+		return;
+	}
+
+	// the boxes stay off, TickComponent sweeps the blades until collision is disabled again
+	for (FHeldWeapon& Held : HeldWeapons)
+	{
+		if (bEnabled)
+		{
+			FTransform BladeStart;
+			FVector BladeEnd;
+			GetBlade(Held, BladeStart, BladeEnd);
+			Held.Swing.Begin(BladeStart, BladeEnd);
+		}
+		else
+			Held.Swing.End();
+	}
+	SetComponentTickEnabled(bEnabled && HeldWeapons.Num() > 0);
+	if (bEnabled)
+		TickSwings();
+}
+
+void UWeaponLoadoutComponent::SetBoxCollisionEnabled(const FHeldWeapon& Held, bool bEnabled) const
+{
+	if (Held.Box == nullptr) return;
+	if (bEnabled)
+	{
+		Held.Box->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+		Held.Box->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Overlap);
+		Held.Box->SetCollisionResponseToChannel(ECollisionChannel::ECC_Pawn, ECollisionResponse::ECR_Ignore);
+	}
+	else
+	{
+		Held.Box->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		Held.Box->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
+	}
+}
+
+void UWeaponLoadoutComponent::GetBlade(const FHeldWeapon& Held, FTransform& OutBladeStart, FVector& OutBladeEnd) const
+{
+	const FTransform& BoxTransform = Held.Box->GetComponentTransform();
+	OutBladeStart = Held.TraceStart * BoxTransform;
+	OutBladeEnd = BoxTransform.TransformPosition(Held.TraceEnd);
+}
+
+const FWeaponSwingSection* UWeaponLoadoutComponent::FindBakedSwing(FName Socket, float& OutSectionTime) const
+{
+	if (SwingTracks.Num() == 0) return nullptr;
+
+	const ACharacter* Character = Cast<ACharacter>(GetOwner());
+	const UAnimInstance* AnimInstance = Character ? Character->GetMesh()->GetAnimInstance() : nullptr;
+	const UAnimMontage* Montage = AnimInstance ? AnimInstance->GetCurrentActiveMontage() : nullptr;
+	if (Montage == nullptr) return nullptr;
+
+	for (const UWeaponSwingTrack* Track : SwingTracks)
+	{
+		if (Track == nullptr || Track->Montage != Montage) continue;
+
+		const FName SectionName = AnimInstance->Montage_GetCurrentSection(Montage);
+		float SectionStart = 0.f;
+		float SectionEnd = 0.f;
+		Montage->GetSectionStartAndEndTime(Montage->GetSectionIndex(SectionName), SectionStart, SectionEnd);
+		OutSectionTime = AnimInstance->Montage_GetPosition(Montage) - SectionStart;
+		return Track->FindSection(SectionName, Socket);
+	}
+	return nullptr;
+}
+
+void UWeaponLoadoutComponent::TickSwings()
+{
+	AActor* Owner = GetOwner();
+	FCollisionQueryParams Params(SCENE_QUERY_STAT(WeaponSwing), false, Owner);
+
+	SwingHits.Reset();
+	for (FHeldWeapon& Held : HeldWeapons)
+	{
+		if (!Held.Swing.IsActive() || Held.Box == nullptr) continue;
+
+		FTransform BladeStart;
+		FVector BladeEnd;
+		float SectionTime = 0.f;
+		if (const FWeaponSwingSection* Baked = FindBakedSwing(Held.Socket, SectionTime))
+		{
+			const FTransform BoxToWorld = Held.Box->GetRelativeTransform() * Baked->Sample(SectionTime) * Owner->GetActorTransform();
+			BladeStart = Held.TraceStart * BoxToWorld;
+			BladeEnd = BoxToWorld.TransformPosition(Held.TraceEnd);
+			// outside the baked window the blade is only followed, so the first sweep inside starts where the window does
+			if (!Baked->IsActive(SectionTime))
+			{
+				Held.Swing.Begin(BladeStart, BladeEnd);
+				continue;
+			}
+		}
+		else
+			GetBlade(Held, BladeStart, BladeEnd);
+		Held.Swing.Advance(GetWorld(), Params, BladeStart, BladeEnd, TraceExtent, SwingHitActors, SwingHits);
+	}
+
+	for (const FHitResult& Hit : SwingHits)
+	{
+		if (WeaponHitbox::CanHit(Owner, Hit.GetActor()))
+			DeliverHit(Hit);
+	}
+}
+
+void UWeaponLoadoutComponent::DeliverHit(const FHitResult& Hit)
+{
+	AActor* Owner = GetOwner();
+	const APawn* OwnerPawn = Cast<APawn>(Owner);
+	WeaponHitbox::ApplyHit(Hit, Damage, OwnerPawn ? OwnerPawn->GetController() : nullptr, Owner, Owner, SwingId,
+		FOnHitResolved::CreateUObject(this, &UWeaponLoadoutComponent::OnHitResolved));
+}
+
+void UWeaponLoadoutComponent::OnHitResolved(const FHitResult& Hit)
+{
+	OnWeaponHit.Broadcast(Hit.ImpactPoint);
+}
+
+TOptional<EWeaponType> UWeaponLoadoutComponent::GetWeaponType() const
+{
+	return HeldWeapons.Num() > 0 ? TOptional<EWeaponType>(WeaponType) : TOptional<EWeaponType>();
+}
+
+void UWeaponLoadoutComponent::OnBoxOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
+{
+	AActor* Owner = GetOwner();
+	if (!WeaponHitbox::CanHit(Owner, OtherActor)) return;
+
+	const FHeldWeapon* Held = HeldWeapons.FindByPredicate([OverlappedComponent](const FHeldWeapon& Weapon) { return Weapon.Box == OverlappedComponent; });
+	if (Held == nullptr) return;
+
+	FTransform BladeStart;
+	FVector BladeEnd;
+	GetBlade(*Held, BladeStart, BladeEnd);
+	FHitResult BoxHit;
+	WeaponHitbox::BoxTrace(Owner, BladeStart.GetLocation(), BladeEnd, TraceExtent, BladeStart.Rotator(), IgnoreActors, bShowTraceDebug, BoxHit);
+
+	if (BoxHit.GetActor() && WeaponHitbox::CanHit(Owner, BoxHit.GetActor()))
+		DeliverHit(BoxHit);
+}
@@ -7,24 +7,43 @@
 #include "Components/SkeletalMeshComponent.h"
 #include "Perception/PawnSensingComponent.h"
 #include "Components/AttributeComponent.h"
+#include "Components/WeaponLoadoutComponent.h"
+#include "Components/CombatStatusComponent.h"
 #include "Rashepur/Weapons/Weapon.h"
 #include "HUD/HealthBarComponent.h"
 #include "Navigation/PathFollowingComponent.h"
 #include "Kismet/KismetMathLibrary.h"
 #include "Math/UnrealMathUtility.h"
+#include "AI/EnemyAIManager.h"
+#include "AI/EnemyPerceptionSubsystem.h"
+#include "AI/EnemyNavPathCache.h"
+#include "AI/PatrolRouteSubsystem.h"
+#include "AI/EnemyProxySubsystem.h"
+#include "AI/EnemyPoolSubsystem.h"
+#include "Components/CapsuleComponent.h"
+#include "Spatial/SpatialHashSubsystem.h"
+#include "Characters/CharacterStateTransitions.h"
 
 AEnemy::AEnemy()
 {
-	PrimaryActorTick.bCanEverTick = true;
+	// decisions are run by UEnemyAIManager, the actor itself never ticks
+	PrimaryActorTick.bCanEverTick = false;
 
 	// Class default collision setup
 	GetMesh()->SetCollisionObjectType(ECollisionChannel::ECC_WorldDynamic);
 	GetMesh()->SetCollisionResponseToChannel(ECollisionChannel::ECC_Visibility, ECollisionResponse::ECR_Block);
 	GetMesh()->SetCollisionResponseToChannel(ECollisionChannel::ECC_Camera, ECollisionResponse::ECR_Ignore);
 	GetMesh()->SetGenerateOverlapEvents(true);
+	// the anim tick rate is set by UEnemyAIManager's animation budget instead of URO's own screen size heuristic
+	GetMesh()->bEnableUpdateRateOptimizations = true;
+	GetMesh()->EnableExternalTickRateControl(true);
+	GetMesh()->SetExternalTickRate(1);
 
 	HealthBarWidget = CreateDefaultSubobject<UHealthBarComponent>(TEXT("HealthBarDisplay"));
 	HealthBarWidget->SetupAttachment(GetRootComponent());
+
+	WeaponLoadout = CreateDefaultSubobject<UWeaponLoadoutComponent>(TEXT("WeaponLoadout"));
+	CombatStatus->SetFaction(ECombatFaction::ECF_Enemy);
  
 	GetCharacterMovement()->bOrientRotationToMovement = true;
 	bUseControllerRotationYaw = false;
@@ -34,22 +53,167 @@ AEnemy::AEnemy()
 	HitReactEndedDelegate.BindUObject(this, &AEnemy::TurnToPlayer);
 }
 
-void AEnemy::Tick(float DeltaTime)
+void AEnemy::ApplyAIDecision(EEnemyAIDecision Decision, bool bInCombatRadius, float DeltaTime)
 {
-	if (IsDead() || IsStaggered()) return;
-
-	Super::Tick(DeltaTime);
+	if (Decision == EEnemyAIDecision::EAD_ReachedPatrolTarget)
+	{
+		ReachedPatrolTarget();
+		return;
+	}
 	if (EnemyState > EEnemyState::EES_Patrolling)
 	{
-		CheckCombatTarget();
-		if (IsSearching() && !IsOutsideCombatRadius())
+		ApplyCombatDecision(Decision);
+		if (IsSearching() && bInCombatRadius)
 			ExpandSight(DeltaTime);
-	} 
-	else
+	}
+}
+const AEnemy::FEnemyStateHandler AEnemy::EnemyStateEnterHandlers[(int32)EEnemyState::EES_MAX] =
+{
+	/* Staggered */ &AEnemy::EnterStaggered,
+	/* Dead */ &AEnemy::EnterUnstaggered,
+	/* Patrolling */ &AEnemy::EnterPatrolling,
+	/* Chasing */ &AEnemy::EnterChasing,
+	/* Searching */ &AEnemy::EnterUnstaggered,
+	/* Engaged */ &AEnemy::EnterUnstaggered,
+	/* NoState */ &AEnemy::EnterUnstaggered,
+};
+
+void AEnemy::SetEnemyState(EEnemyState NewState)
+{
+#if RASHEPUR_WITH_STATE_STATS
+	ensureMsgf(CharacterStateTransitions::IsLegal(EnemyState, NewState), TEXT("%s: illegal enemy state change %s -> %s"),
+		*GetName(), *UEnum::GetValueAsString(EnemyState), *UEnum::GetValueAsString(NewState));
+	CharacterStateTransitions::RecordTransition(EnemyState, NewState);
+#endif
+	EnemyState = NewState;
+	EnterEnemyState(NewState);
+}
+
+template<EEnemyState To, EEnemyState... From>
+void AEnemy::TransitionEnemyState()
+{
+	static_assert(sizeof...(From) > 0, "List the states the call site can be in");
+	static_assert(CharacterStateTransitions::AreLegal<To, From...>(), "Illegal enemy state change at a fixed call site, see CharacterStateTransitions");
+#if RASHEPUR_WITH_STATE_STATS
+	ensureMsgf(CharacterStateTransitions::Bits<From...>() & CharacterStateTransitions::Bit(EnemyState), TEXT("%s: entered %s from unexpected %s"),
+		*GetName(), *UEnum::GetValueAsString(To), *UEnum::GetValueAsString(EnemyState));
+	CharacterStateTransitions::RecordTransition(EnemyState, To);
+#endif
+	EnemyState = To;
+	EnterEnemyState(To);
+}
+
+void AEnemy::EnterEnemyState(EEnemyState NewState)
+{
+	(this->*EnemyStateEnterHandlers[(int32)NewState])();
+	UpdateAIActivity();
+}
+
+void AEnemy::EnterStaggered()
+{
+	CombatStatus->SetStatus(ECombatStatus::ECST_Staggered, true);
+}
+
+void AEnemy::EnterPatrolling()
+{
+	EnterUnstaggered();
+	GetCharacterMovement()->MaxWalkSpeed = PatrollingSpeed;
+}
+
+void AEnemy::EnterChasing()
+{
+	EnterUnstaggered();
+	GetCharacterMovement()->MaxWalkSpeed = ChasingSpeed;
+}
+
+void AEnemy::EnterUnstaggered()
+{
+	CombatStatus->SetStatus(ECombatStatus::ECST_Staggered, false);
+}
+
+void AEnemy::PublishAnimSnapshot(FCharacterAnimSnapshot& OutSnapshot) const
+{
+	Super::PublishAnimSnapshot(OutSnapshot);
+	OutSnapshot.EnemyState = EnemyState;
+}
+
+bool AEnemy::NeedsAIDecisions() const
+{
+	// patrolling moves on OnMoveCompleted and PawnSeen, staggered and dead on timers and montages
+	return CharacterStateTransitions::EnemyStateNeedsDecisions[(int32)EnemyState];
+}
+
+void AEnemy::UpdateAIActivity()
+{
+	if (AIManagerIndex != INDEX_NONE)
+	{
+		if (UEnemyAIManager* AIManager = GetWorld()->GetSubsystem<UEnemyAIManager>())
+			AIManager->SetEnemyActive(this, NeedsAIDecisions());
+	}
+
+	// a corpse killed mid air keeps its movement until it lands, OnMovementModeChanged comes back here
+	const UCharacterMovementComponent* Movement = GetCharacterMovement();
+	const bool bCorpseSettled = IsDead() && (Movement->IsMovingOnGround() || Movement->MovementMode == MOVE_None);
+	const bool bIdle = bCorpseSettled || (IsPatrolling() && bWaitingAtPatrolPoint);
+	GetCharacterMovement()->SetComponentTickEnabled(!bIdle);
+	if (PawnSensing && IsDead())
+		PawnSensing->SetSensingUpdatesEnabled(false);
+	UpdateAnimSharing();
+}
+
+void AEnemy::OnMovementModeChanged(EMovementMode PrevMovementMode, uint8 PreviousCustomMode)
+{
+	Super::OnMovementModeChanged(PrevMovementMode, PreviousCustomMode);
+	if (IsDead() && GetCharacterMovement()->IsMovingOnGround())
+	{
+		// landed, the corpse no longer needs a floor
+		DisableCapsule();
+		UpdateAIActivity();
+	}
+}
+
+void AEnemy::UpdateAnimSharing()
+{
+	UEnemyAnimSharingSubsystem* AnimSharing = GetWorld()->GetSubsystem<UEnemyAnimSharingSubsystem>();
+	if (AnimSharing == nullptr) return;
+
+	// only calm states share, combat, hit reacts (Staggered) and death always evaluate their own pose
+	EEnemyAnimShareState ShareState = EEnemyAnimShareState::None;
+	if (AIManagerIndex != INDEX_NONE && UEnemyAnimSharingSubsystem::IsEnabled())
 	{
-		CheckPatrolTarget();
+		if (IsPatrolling())
+			ShareState = bWaitingAtPatrolPoint ? EEnemyAnimShareState::Idle : EEnemyAnimShareState::PatrolWalk;
+		else if (IsSearching())
+			ShareState = EEnemyAnimShareState::LookAround;
 	}
+	AnimSharing->SetShareState(this, ShareState);
 }
+
+void AEnemy::OnMoveCompleted(FAIRequestID RequestID, EPathFollowingResult::Type Result)
+{
+	// blocked legs pick another point instead of standing there forever
+	if (IsPatrolling() && !bWaitingAtPatrolPoint && (Result == EPathFollowingResult::Success || Result == EPathFollowingResult::Blocked))
+		ReachedPatrolTarget();
+}
+
+void AEnemy::ApplyAILODTier(const FEnemyAILODTier& Tier)
+{
+	if (PawnSensing)
+		PawnSensing->SetSensingInterval(Tier.SensingInterval > 0.f ? Tier.SensingInterval : DefaultSensingInterval);
+	GetCharacterMovement()->SetComponentTickInterval(Tier.MovementTickInterval);
+}
+
+void AEnemy::SetAnimTickRate(uint8 TickRate)
+{
+	GetMesh()->SetExternalTickRate(FMath::Max<uint8>(TickRate, 1));
+}
+
+void AEnemy::SetSensingInRange(bool bInRange)
+{
+	if (PawnSensing)
+		PawnSensing->SetSensingUpdatesEnabled(bInRange && !IsDead());
+}
+
 void AEnemy::TurnToPlayer(UAnimMontage* Montage, bool bInterrupted)
 {
 	if (CombatTarget && !CanSeeTarget(CombatTarget))
@@ -76,14 +240,6 @@ float AEnemy::TakeDamage(float DamageAmount, FDamageEvent const& DamageEvent, AC
 	return DamageAmount;
 }
 
-void AEnemy::Destroyed()
-{
-	if (EquippedWeapon)
-	{
-		EquippedWeapon->Destroy();
-	}
-}
-
 void AEnemy::GetHit_Implementation(const FVector& ImpactPoint, AActor* Hitter)
 {
 	UAnimInstance* HitAnimInstance;
@@ -108,11 +264,10 @@ void AEnemy::GetHit_Implementation(const FVector& ImpactPoint, AActor* Hitter)
 
 void AEnemy::Stagger()
 {
-	EnemyState = EEnemyState::EES_Staggered;
+	SetEnemyState(EEnemyState::EES_Staggered);
 	StopAllActions();
 
-	if (bDebugStates)
-		UE_LOG(LogTemp, Warning, TEXT("EnemyState set to EES_Stagger Enemy (Stagger)"));
+	RASHEPUR_STATE_LOG(bDebugStates, Warning, TEXT("EnemyState set to EES_Stagger Enemy (Stagger)"));
 	StartStaggerRecoverTimer();
 }
 
@@ -126,44 +281,202 @@ void AEnemy::OnActionEnded(UAnimMontage* Montage, bool bInterrupted)
 
 void AEnemy::ClearStates()
 {
-	EnemyState = EEnemyState::EES_NoState;
-	ActionState = EActionState::EAS_Unoccupied;
-	if (bDebugStates)
-	{
-		UE_LOG(LogTemp, Warning, TEXT("EnemyState set to EES_NoState Enemy (OnActionEnded)"));
-		UE_LOG(LogTemp, Warning, TEXT("ActionState set to EAS_Unoccupied Enemy (OnActionEnded)"));
-	}
+	SetEnemyState(EEnemyState::EES_NoState);
+	SetActionState(EActionState::EAS_Unoccupied);
+	RASHEPUR_STATE_LOG(bDebugStates, Warning, TEXT("EnemyState set to EES_NoState Enemy (OnActionEnded)"));
+	RASHEPUR_STATE_LOG(bDebugStates, Warning, TEXT("ActionState set to EAS_Unoccupied Enemy (OnActionEnded)"));
 }
 
 void AEnemy::BeginPlay()
 {
 	Super::BeginPlay();
-	if (HealthBarWidget)	
-		HealthBarWidget->SetHealthPercent(CharAttributes->GetHealthPercent());
 	if (PawnSensing)
 		PawnSensing->OnSeePawn.AddDynamic(this, &AEnemy::PawnSeen);
 	InitializeEnemy();
-	MoveTo(PatrolTarget);
+	ActivateEnemy();
+}
+
+void AEnemy::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UnregisterFromSubsystems();
+	Super::EndPlay(EndPlayReason);
 }
 
 void AEnemy::InitializeEnemy()
 {
+	// once per actor, a pooled enemy keeps its controller, bindings and weapon between lives
 	EnemyController = Cast<AAIController>(GetController());
-	HideHealthBar();
+	if (EnemyController)
+		EnemyController->ReceiveMoveCompleted.AddDynamic(this, &AEnemy::OnMoveCompleted);
+	Perception = GetWorld()->GetSubsystem<UEnemyPerceptionSubsystem>();
+	NavPathCache = GetWorld()->GetSubsystem<UEnemyNavPathCache>();
+	if (PawnSensing)
+		DefaultSensingInterval = PawnSensing->SensingInterval;
 	EquipDefaultWeapon();
 	Tags.Add("Enemy");
 }
 
+void AEnemy::ActivateEnemy()
+{
+	if (HealthBarWidget)
+		HealthBarWidget->SetHealthPercent(CharAttributes->GetHealthPercent());
+	HideHealthBar();
+	if (UPatrolRouteSubsystem* PatrolRoutes = GetWorld()->GetSubsystem<UPatrolRouteSubsystem>())
+		PatrolRoute = PatrolRoutes->FindOrBakeRoute(PatrolTargets, EnemyController);
+	PatrolTargetIndex = PatrolRoute ? PatrolRoute->IndexOf(PatrolTarget) : INDEX_NONE;
+	RegisterWithSubsystems();
+	MoveTo(PatrolTarget);
+}
+
+void AEnemy::RegisterWithSubsystems()
+{
+	if (UEnemyAIManager* AIManager = GetWorld()->GetSubsystem<UEnemyAIManager>())
+		AIManager->RegisterEnemy(this);
+	if (USpatialHashSubsystem* SpatialHash = GetWorld()->GetSubsystem<USpatialHashSubsystem>())
+		SpatialHash->Register(this, ESpatialCategory::Enemy);
+	if (UEnemyProxySubsystem* Proxies = GetWorld()->GetSubsystem<UEnemyProxySubsystem>())
+		Proxies->RegisterEnemy(this);
+	UpdateAnimSharing();
+}
+
+void AEnemy::UnregisterFromSubsystems()
+{
+	if (UEnemyAIManager* AIManager = GetWorld()->GetSubsystem<UEnemyAIManager>())
+		AIManager->UnregisterEnemy(this);
+	if (USpatialHashSubsystem* SpatialHash = GetWorld()->GetSubsystem<USpatialHashSubsystem>())
+		SpatialHash->Unregister(this);
+	if (UEnemyProxySubsystem* Proxies = GetWorld()->GetSubsystem<UEnemyProxySubsystem>())
+		Proxies->UnregisterEnemy(this);
+	// AIManagerIndex is cleared by now, so this leaves any leader pose group
+	UpdateAnimSharing();
+}
+
+void AEnemy::SetPatrolTargets(const TArray<AActor*>& NewPatrolTargets, AActor* NewPatrolTarget)
+{
+	PatrolTargets = NewPatrolTargets;
+	PatrolTarget = NewPatrolTarget;
+	PatrolPointIndex = INDEX_NONE;
+}
+
+void AEnemy::ParkInPool()
+{
+	UnregisterFromSubsystems();
+	GetWorldTimerManager().ClearAllTimersForObject(this);
+	bWaitingAtPatrolPoint = false;
+	if (EnemyController)
+		EnemyController->StopMovement();
+	if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
+		AnimInstance->StopAllMontages(0.f);
+	SetWeaponCollisionEnabled(ECollisionEnabled::NoCollision);
+	SetActorEnableCollision(false);
+	SetActorHiddenInGame(true);
+	GetMesh()->SetComponentTickEnabled(false);
+	GetCharacterMovement()->SetComponentTickEnabled(false);
+	if (PawnSensing)
+		PawnSensing->SetSensingUpdatesEnabled(false);
+}
+
+void AEnemy::ResetFromPool(const FTransform& Transform)
+{
+	SetActorTransform(Transform, false, nullptr, ETeleportType::ResetPhysics);
+	if (CharAttributes)
+		CharAttributes->SetHealth(CharAttributes->GetMaxHealth());
+	Tags.Remove(FName("Dead"));
+	CombatStatus->SetStatus(ECombatStatus::ECST_Dead | ECombatStatus::ECST_Staggered, false);
+
+	// a new life rather than a state transition, Dead -> Patrolling is not an edge of the state tables
+	EnemyState = EEnemyState::EES_Patrolling;
+	ActionState = EActionState::EAS_Unoccupied;
+	CombatTarget = nullptr;
+	PatrolPointIndex = INDEX_NONE;
+	ResetPeripheralVision();
+
+	// Die turned the capsule off or down to world only for the fall, take the class settings back
+	const UCapsuleComponent* DefaultCapsule = GetClass()->GetDefaultObject<AEnemy>()->GetCapsuleComponent();
+	GetCapsuleComponent()->SetCollisionResponseToChannels(DefaultCapsule->GetCollisionResponseToChannels());
+	GetCapsuleComponent()->SetCollisionEnabled(DefaultCapsule->GetCollisionEnabled());
+	SetActorEnableCollision(true);
+	SetActorHiddenInGame(false);
+	GetMesh()->SetComponentTickEnabled(true);
+	GetCharacterMovement()->SetComponentTickEnabled(true);
+	GetCharacterMovement()->MaxWalkSpeed = PatrollingSpeed;
+	if (PawnSensing)
+		PawnSensing->SetSensingUpdatesEnabled(true);
+}
+
+void AEnemy::ScheduleDeathCleanup()
+{
+	if (GetWorld()->GetSubsystem<UEnemyPoolSubsystem>() == nullptr || DeathLifeSpan <= 0.f)
+	{
+		Super::ScheduleDeathCleanup();
+		return;
+	}
+	// the body stays for DeathLifeSpan as before, then it is parked instead of destroyed
+	GetWorldTimerManager().SetTimer(DeathCleanupTimer, this, &AEnemy::ReleaseToPool, DeathLifeSpan);
+}
+
+void AEnemy::ReleaseToPool()
+{
+	if (UEnemyPoolSubsystem* Pool = GetWorld()->GetSubsystem<UEnemyPoolSubsystem>())
+		Pool->Release(this);
+	else
+		Destroy();
+}
+
+bool AEnemy::CanBeDemoted()
+{
+	// only calm enemies, a fight or a death in progress has timers and montages that cannot be captured
+	return IsAlive() && CombatTarget == nullptr && (IsPatrolling() || EnemyState == EEnemyState::EES_NoState);
+}
+
+void AEnemy::CaptureProxyState(FEnemyProxyFragment& Proxy) const
+{
+	Proxy.EnemyClass = GetClass();
+	Proxy.Transform = GetActorTransform();
+	Proxy.Health = CharAttributes ? CharAttributes->GetHealth() : 0.f;
+	Proxy.EnemyState = EnemyState;
+	Proxy.PatrolTarget = PatrolTarget;
+	Proxy.PatrolTargets.Reset(PatrolTargets.Num());
+	for (AActor* Target : PatrolTargets)
+		Proxy.PatrolTargets.Add(Target);
+	Proxy.PatrolPointIndex = PatrolPointIndex;
+}
+
+void AEnemy::RestoreProxyState(const FEnemyProxyFragment& Proxy)
+{
+	if (CharAttributes)
+		CharAttributes->SetHealth(Proxy.Health);
+	EnemyState = Proxy.EnemyState;
+	PatrolTarget = Proxy.PatrolTarget.Get();
+	PatrolTargets.Reset(Proxy.PatrolTargets.Num());
+	for (const TWeakObjectPtr<AActor>& Target : Proxy.PatrolTargets)
+		if (AActor* PatrolPoint = Target.Get())
+			PatrolTargets.Add(PatrolPoint);
+	PatrolPointIndex = Proxy.PatrolPointIndex;
+}
+
 void AEnemy::Die()
 {
 	StopAllActions();
+	ClearStaggerRecoverTimer();
 	Super::Die();
+	if (GetCharacterMovement()->IsFalling())
+	{
+		// without a capsule a corpse killed mid air would fall through the floor, it only blocks the world until it lands
+		UCapsuleComponent* Capsule = GetCapsuleComponent();
+		Capsule->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+		Capsule->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
+		Capsule->SetCollisionResponseToChannel(ECollisionChannel::ECC_WorldStatic, ECollisionResponse::ECR_Block);
+		Capsule->SetCollisionResponseToChannel(ECollisionChannel::ECC_WorldDynamic, ECollisionResponse::ECR_Block);
+	}
 	HideHealthBar();
 	SetWeaponCollisionEnabled(ECollisionEnabled::NoCollision);
-	EnemyState = EEnemyState::EES_Dead;
+	// a lethal hit can land in any state, a corpse hit again dies again
+	TransitionEnemyState<EEnemyState::EES_Dead,
+		EEnemyState::EES_Staggered, EEnemyState::EES_Dead, EEnemyState::EES_Patrolling, EEnemyState::EES_Chasing,
+		EEnemyState::EES_Searching, EEnemyState::EES_Engaged, EEnemyState::EES_NoState>();
 
-	if (bDebugStates)
-		UE_LOG(LogTemp, Warning, TEXT("EnemyState set to EES_Dead Enemy (die)"));
+	RASHEPUR_STATE_LOG(bDebugStates, Warning, TEXT("EnemyState set to EES_Dead Enemy (die)"));
 }
 
 void AEnemy::Attack()
@@ -208,12 +521,24 @@ void AEnemy::MoveTo(AActor* Target, bool DrawDebugSpheresOnPath)
 {
 	if (EnemyController && Target)
 	{
+		if (IsAlreadyMovingTo(Target))
+		{
+			if (NavPathCache)
+				NavPathCache->RecordSuppressedRepath();
+			return;
+		}
+
 		FAIMoveRequest MoveRequest;
 		MoveRequest.SetGoalActor(Target);
 		MoveRequest.SetAcceptanceRadius(MoveAcceptanceRadius);
 		FNavPathSharedPtr NavPath;
-		EnemyController->MoveTo(MoveRequest, &NavPath); // navpath outparameter, a gente passa o parametro e a funcao muda o valor dele
-		if (DrawDebugSpheresOnPath)
+		if (NavPathCache)
+			NavPathCache->MoveTo(EnemyController, MoveRequest, &NavPath);
+		else
+			EnemyController->MoveTo(MoveRequest, &NavPath); // navpath outparameter, a gente passa o parametro e a funcao muda o valor dele
+		LastMoveGoal = Target;
+		LastMoveGoalLocation = Target->GetActorLocation();
+		if (DrawDebugSpheresOnPath && NavPath.IsValid())
 		{
 			TArray<FNavPathPoint> PathPoints = NavPath->GetPathPoints();
 			for (auto& Point : PathPoints)
@@ -225,33 +550,47 @@ void AEnemy::MoveTo(AActor* Target, bool DrawDebugSpheresOnPath)
 	}
 }
 
+bool AEnemy::IsAlreadyMovingTo(AActor* Target) const
+{
+	// path following keeps tracking a goal actor by itself, a new request only matters once it has moved away
+	return EnemyController->GetMoveStatus() == EPathFollowingStatus::Moving &&
+		LastMoveGoal.Get() == Target &&
+		FVector::DistSquared(Target->GetActorLocation(), LastMoveGoalLocation) <= FMath::Square(RepathTolerance);
+}
+
 void AEnemy::EquipDefaultWeapon()
 {
-	UWorld* World = GetWorld();
-	if (World && DefaultWeaponClass)
+	if (WeaponLoadout && DefaultWeaponClass)
 	{
-		AWeapon* DefaultWeapon = World->SpawnActor<AWeapon>(DefaultWeaponClass);
-		DefaultWeapon->Equip(GetMesh(), GetWeaponSocket(DefaultWeapon), this, this);
-		if (DefaultWeapon->GetWeaponType() == EWeaponType::EWT_BothHands) 
-		{
-			AWeapon* SecondWeapon = World->SpawnActor<AWeapon>(DefaultWeaponClass);
-			SecondWeapon->Equip(GetMesh(), FName("OneHandedSocket"), this, this);
-		}
-
-		EquippedWeapon = DefaultWeapon;
+		// DefaultWeaponClass only supplies the mesh, hit box and damage, no AWeapon actor is spawned
+		const EWeaponType WeaponType = DefaultWeaponClass->GetDefaultObject<AWeapon>()->GetWeaponType();
+		WeaponLoadout->Equip(DefaultWeaponClass, GetMesh(), GetWeaponSocket(WeaponType), FName("OneHandedSocket"));
 		SetCharacterStateByWeaponType();
-		
 	}
 }
 
+void AEnemy::SetWeaponCollisionEnabled(ECollisionEnabled::Type CollisionEnabled)
+{
+	if (WeaponLoadout)
+		WeaponLoadout->SetWeaponCollisionEnabled(CollisionEnabled);
+}
+
+TOptional<EWeaponType> AEnemy::GetHeldWeaponType() const
+{
+	return WeaponLoadout ? WeaponLoadout->GetWeaponType() : TOptional<EWeaponType>();
+}
+
 void AEnemy::PawnSeen(APawn* SeenPawn)
 {
+	if (Perception)
+		Perception->NotifySeen(PawnSensing, SeenPawn);
+
 	const bool bShouldChaseTarget =
 		!IsStaggered() &&
 		IsAlive() &&
 		!IsEngaged() &&		
 		!IsAttacking() &&
-		SeenPawn->ActorHasTag(FName("Hero"));
+		UCombatStatusComponent::GetAttitude(this, SeenPawn) == ECombatAttitude::ECA_Hostile;
 
 	if (IsSearching())
 	{
@@ -270,89 +609,46 @@ void AEnemy::PawnSeen(APawn* SeenPawn)
 
 void AEnemy::StaggerRecover()
 {
-	ActionState = EActionState::EAS_Unoccupied;
-	EnemyState = EEnemyState::EES_NoState;
-	if (bDebugStates)
-		UE_LOG(LogTemp, Warning, TEXT("EnemyState set to EES_NoState Enemy (StaggerRecover)"));
-	if (bDebugStates)
-		UE_LOG(LogTemp, Warning, TEXT("ActionState set to EAS_Unoccupied Enemy (StaggerRecover)"));
+	// killed while staggered, Dead is terminal
+	if (IsDead()) return;
+
+	SetActionState(EActionState::EAS_Unoccupied);
+	SetEnemyState(EEnemyState::EES_NoState);
+	RASHEPUR_STATE_LOG(bDebugStates, Warning, TEXT("EnemyState set to EES_NoState Enemy (StaggerRecover)"));
+	RASHEPUR_STATE_LOG(bDebugStates, Warning, TEXT("ActionState set to EAS_Unoccupied Enemy (StaggerRecover)"));
 }
 
-void AEnemy::CheckCombatTarget()
+void AEnemy::ApplyCombatDecision(EEnemyAIDecision Decision)
 {
-	if (IsOutsideCombatRadius())
+	switch (Decision)
 	{
+	case EEnemyAIDecision::EAD_LoseInterest:
 		ClearAttackTimer();
 		LoseInterest();
 		ResetPeripheralVision();
 		if (!IsEngaged()) 
 			StartPatrolling();
-	}
-	else if (CanChase())
-	{
+		break;
+	case EEnemyAIDecision::EAD_Chase:
 		ClearAttackTimer();
 		if (!IsEngaged())
 			ChaseTarget(); // seta pra chasing
-	}
-	else if (CanSearch())
-	{
+		break;
+	case EEnemyAIDecision::EAD_Search:
 		SearchForTarget();
-	}
-	else if (CanEngage())
-	{
+		break;
+	case EEnemyAIDecision::EAD_Engage:
 		EngageTarget();
-	} 
-	else if (IsCombatTargetDead() && !IsPatrolling())
-	{
+		break;
+	case EEnemyAIDecision::EAD_CombatTargetDead:
 		ClearAttackTimer();
 		LoseInterest();
 		ResetPeripheralVision();
 		StartPatrolling();
+		break;
 	}
 }
 
-bool AEnemy::CanEngage()
-{
-	return IsInsideAttackRadius() && 
-		!IsEngaged() && 
-		!IsAttacking() && 
-		CanSeeTarget(CombatTarget) && 
-		!IsSearching();
-}
-
-bool AEnemy::CanSearch()
-{
-	return !IsOutsideCombatRadius() && 
-		!IsAttacking() && 
-		!IsSearching() && !
-		CanSeeTarget(CombatTarget);
-}
-
-bool AEnemy::CanChase()
-{
-	return !IsOutsideCombatRadius() && 
-		IsOutsideAttackRadius() && 
-		!IsChasing() && 
-		!IsSearching() && 
-		CanSeeTarget(CombatTarget);
-}
-
-
-bool AEnemy::IsOutsideCombatRadius() const
-{
-	return !InTargetRange(CombatTarget, CombatRadius);
-}
-
-bool AEnemy::IsOutsideAttackRadius() const
-{
-	return !InTargetRange(CombatTarget, AttackRadius);
-}
-
-bool AEnemy::IsInsideAttackRadius() const
-{
-	return InTargetRange(CombatTarget, AttackRadius);
-}
-
 bool AEnemy::IsAttacking() const
 {
 	return ActionState == EActionState::EAS_Attacking;
@@ -372,10 +668,8 @@ void AEnemy::ChaseTarget()
 {
 	if (IsAlive() && !IsEngaged() && !IsAttacking())
 	{
-		EnemyState = EEnemyState::EES_Chasing;
-		if (bDebugStates)
-			UE_LOG(LogTemp, Warning, TEXT("EnemyState set to EES_Chasing Enemy (ChaseTarget)"));
-		GetCharacterMovement()->MaxWalkSpeed = ChasingSpeed;
+		SetEnemyState(EEnemyState::EES_Chasing);
+		RASHEPUR_STATE_LOG(bDebugStates, Warning, TEXT("EnemyState set to EES_Chasing Enemy (ChaseTarget)"));
 		MoveTo(CombatTarget);
 	}
 }
@@ -383,29 +677,31 @@ void AEnemy::ChaseTarget()
 void AEnemy::LoseInterest()
 {
 	CombatTarget = nullptr;
-	EnemyState = EEnemyState::EES_NoState;
-	ActionState = EActionState::EAS_Unoccupied;
-	if (bDebugStates)
-	{
-		UE_LOG(LogTemp, Warning, TEXT("EnemyState set to EES_NoState Enemy (Start Patrolling)"));
-		UE_LOG(LogTemp, Warning, TEXT("ActionState set to EAS_Unoccupied Enemy (Start Patrolling)"));
-	}
+	SetEnemyState(EEnemyState::EES_NoState);
+	SetActionState(EActionState::EAS_Unoccupied);
+	RASHEPUR_STATE_LOG(bDebugStates, Warning, TEXT("EnemyState set to EES_NoState Enemy (Start Patrolling)"));
+	RASHEPUR_STATE_LOG(bDebugStates, Warning, TEXT("ActionState set to EAS_Unoccupied Enemy (Start Patrolling)"));
 
 	HideHealthBar();
 }
 
 void AEnemy::StartPatrolling()
 {
-	EnemyState = EEnemyState::EES_Patrolling;
-	if (bDebugStates)
-		UE_LOG(LogTemp, Warning, TEXT("EnemyState set to EES_Patrolling Enemy (Start Patrolling)"));
-	GetCharacterMovement()->MaxWalkSpeed = PatrollingSpeed;
+	// coming back from combat, the enemy is somewhere between route points
+	PatrolPointIndex = INDEX_NONE;
+	SetEnemyState(EEnemyState::EES_Patrolling);
+	RASHEPUR_STATE_LOG(bDebugStates, Warning, TEXT("EnemyState set to EES_Patrolling Enemy (Start Patrolling)"));
 	MoveTo(PatrolTarget);
 }
 
 void AEnemy::ClearPatrolTimer() 
 {
 	GetWorldTimerManager().ClearTimer(PatrolTimer);
+	if (bWaitingAtPatrolPoint)
+	{
+		bWaitingAtPatrolPoint = false;
+		UpdateAIActivity();
+	}
 }
 
 void AEnemy::HideHealthBar()
@@ -433,7 +729,34 @@ void AEnemy::ClearAttackTimer()
 
 void AEnemy::PatrolTimerFinished()
 {
-	MoveTo(PatrolTarget);
+	bWaitingAtPatrolPoint = false;
+	UpdateAIActivity();
+	if (!FollowPatrolRoute())
+		MoveTo(PatrolTarget);
+}
+
+bool AEnemy::FollowPatrolRoute()
+{
+	if (EnemyController == nullptr || !PatrolRoute.IsValid() || PatrolTarget == nullptr) return false;
+
+	if (!PatrolPath.IsValid())
+		PatrolPath = MakeShareable(new FNavigationPath());
+	PatrolPath->ResetForRepath();
+	if (!PatrolRoute->GetPath(PatrolPointIndex, PatrolTargetIndex, PatrolPath->GetPathPoints())) return false;
+
+	// the baked leg starts on the route point, the enemy stopped somewhere inside PatrolRadius of it
+	PatrolPath->GetPathPoints()[0].Location = GetNavAgentLocation();
+	PatrolPath->SetNavigationDataUsed(PatrolRoute->NavData.Get());
+	PatrolPath->SetQuerier(EnemyController);
+	PatrolPath->MarkReady();
+
+	FAIMoveRequest MoveRequest(PatrolTarget);
+	MoveRequest.SetAcceptanceRadius(MoveAcceptanceRadius);
+	if (!EnemyController->RequestMove(MoveRequest, PatrolPath).IsValid()) return false;
+
+	LastMoveGoal = PatrolTarget;
+	LastMoveGoalLocation = PatrolTarget->GetActorLocation();
+	return true;
 }
 
 bool AEnemy::IsDead() const
@@ -453,21 +776,20 @@ bool AEnemy::IsSearching() const
 
 bool AEnemy::CanSeeTarget(APawn* Target) const
 {
-	if (Target == nullptr) return false;
-	if (PawnSensing)
-		return PawnSensing->CouldSeePawn(Target);
-	else
-		return false;
+	if (Target == nullptr || PawnSensing == nullptr) return false;
+	if (Perception)
+		return Perception->CanSee(PawnSensing, Target);
+	return PawnSensing->CouldSeePawn(Target);
 }
 
 void AEnemy::SearchForTarget()
 {
-	ActionState = EActionState::EAS_Occupied;
-	EnemyState = EEnemyState::EES_Searching;
+	SetActionState(EActionState::EAS_Occupied);
+	// only reached through EAD_Search, which EnemyDecisionCore gives combat states other than Searching
+	TransitionEnemyState<EEnemyState::EES_Searching, EEnemyState::EES_Chasing, EEnemyState::EES_Engaged, EEnemyState::EES_NoState>();
 
 	ClearAttackTimer();
-	if (bDebugStates)
-		UE_LOG(LogTemp, Display, TEXT("EnemyState set to EES_Searching Enemy (CheckCombatTarget)"));
+	RASHEPUR_STATE_LOG(bDebugStates, Display, TEXT("EnemyState set to EES_Searching Enemy (CheckCombatTarget)"));
 	GetCharacterMovement()->StopMovementImmediately();
 	PlaySearchMontage();
 	StartSearchTimer(GetSearchMontageLength()* SearchAnimationLoopNTimes);
@@ -475,9 +797,9 @@ void AEnemy::SearchForTarget()
 
 void AEnemy::EngageTarget()
 {
-	EnemyState = EEnemyState::EES_Engaged;
-	if (bDebugStates)
-		UE_LOG(LogTemp, Warning, TEXT("EnemyState set to EES_Engaged Enemy (CheckCombatTarget)"));
+	// only reached through EAD_Engage, which EnemyDecisionCore never gives Engaged or Searching enemies
+	TransitionEnemyState<EEnemyState::EES_Engaged, EEnemyState::EES_Chasing, EEnemyState::EES_NoState>();
+	RASHEPUR_STATE_LOG(bDebugStates, Warning, TEXT("EnemyState set to EES_Engaged Enemy (CheckCombatTarget)"));
 	if (CanAttack())
 	{
 		StartAttackTimer();
@@ -527,39 +849,29 @@ void AEnemy::ClearStaggerRecoverTimer()
 
 AActor* AEnemy::ChoosePatrolTarget()
 {
-	// remove do array de patroltargets o atual pra nao repetir
-	TArray<AActor*> ValidTargets;
-	for (AActor* Target : PatrolTargets)
-		if (Target != PatrolTarget)
-			ValidTargets.AddUnique(Target);
-
-	if (ValidTargets.Num() > 0)
+	// sorteia qualquer ponto da rota menos o atual, pulando o indice dele em vez de montar um array
+	const int32 NumPoints = PatrolRoute ? PatrolRoute->Num() : 0;
+	const int32 NumCandidates = EnemyDecisionCore::NumPatrolCandidates(NumPoints, PatrolPointIndex);
+	if (NumCandidates <= 0)
 	{
-		const int32 NextPatrolTarget = FMath::RandRange(0,ValidTargets.Num()-1);
-		return ValidTargets[NextPatrolTarget];
+		PatrolTargetIndex = INDEX_NONE;
+		return nullptr;
 	}
-    return nullptr;
-}
 
-bool AEnemy::InTargetRange(AActor *Target, double Radius) const
-{
-	if (Target == nullptr) return false;
-	double DistanceToTarget = (Target->GetActorLocation() - GetActorLocation()).Size();
-	//DRAW_SPHERE_SingleFrame(GetActorLocation());
-	//DRAW_SPHERE_SingleFrame(Target->GetActorLocation());
-	if (DistanceToTarget < 0)
-		DistanceToTarget *= -1;
-    return DistanceToTarget <= Radius;
+	PatrolTargetIndex = EnemyDecisionCore::PatrolIndexFromCandidate(FMath::RandRange(0, NumCandidates - 1), PatrolPointIndex);
+	return PatrolRoute->Points[PatrolTargetIndex].Get();
 }
 
-void AEnemy::CheckPatrolTarget()
+void AEnemy::ReachedPatrolTarget()
 {
-	// isso aqui vai ser executado a cada frame, ou seja, sempre que chegar no alvo, vai resetar o array de alvos validos
-	if (InTargetRange(PatrolTarget, PatrolRadius)) // chegou no proximo alvo
-	{
-		PatrolTarget = ChoosePatrolTarget();
-		// vai executar a funcao depois de 5 segundos
-		int32 WaitTime = FMath::RandRange(MinWaitBeforePatrol, MaxWaitBeforePatrol);
-		GetWorldTimerManager().SetTimer(PatrolTimer, this, &AEnemy::PatrolTimerFinished, WaitTime);
-	}
+	// PatrolTarget may have been set from Blueprint, find it on the route instead of trusting the index
+	if (PatrolRoute && !(PatrolRoute->Points.IsValidIndex(PatrolTargetIndex) && PatrolRoute->Points[PatrolTargetIndex] == PatrolTarget))
+		PatrolTargetIndex = PatrolRoute->IndexOf(PatrolTarget);
+	PatrolPointIndex = PatrolTargetIndex;
+	PatrolTarget = ChoosePatrolTarget();
+	// vai executar a funcao depois de 5 segundos
+	int32 WaitTime = FMath::RandRange(MinWaitBeforePatrol, MaxWaitBeforePatrol);
+	GetWorldTimerManager().SetTimer(PatrolTimer, this, &AEnemy::PatrolTimerFinished, WaitTime);
+	bWaitingAtPatrolPoint = true;
+	UpdateAIActivity();
 }
\ No newline at end of file
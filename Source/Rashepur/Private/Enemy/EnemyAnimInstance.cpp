@@ -3,12 +3,18 @@
 
 #include "Enemy/EnemyAnimInstance.h"
 #include "Enemy/Enemy.h"
-#include "Kismet/KismetMathLibrary.h"
+#include "Rashepur.h"
 #include "GameFramework/CharacterMovementComponent.h"
 
 
+DECLARE_CYCLE_STAT(TEXT("Enemy Anim Game Thread Update"), STAT_EnemyAnimGameThreadUpdate, STATGROUP_Rashepur);
+DECLARE_CYCLE_STAT(TEXT("Enemy Anim Thread Safe Update"), STAT_EnemyAnimThreadSafeUpdate, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemy Anim Updates Off Game Thread"), STAT_EnemyAnimUpdatesOffGameThread, STATGROUP_Rashepur);
+
 void UEnemyAnimInstance::NativeInitializeAnimation()
 {
+    Super::NativeInitializeAnimation();
+
     Enemy = Cast<AEnemy>(TryGetPawnOwner());
     if (Enemy)
     {
@@ -16,16 +22,29 @@ void UEnemyAnimInstance::NativeInitializeAnimation()
     }
 }
 
+void UEnemyAnimInstance::NativeBeginPlay()
+{
+    Super::NativeBeginPlay();
+    CharacterAnim::WarnIfGameThreadOnly(this);
+}
+
 void UEnemyAnimInstance::NativeUpdateAnimation(float DeltaTime)
 {
+    SCOPE_CYCLE_COUNTER(STAT_EnemyAnimGameThreadUpdate);
     Super::NativeUpdateAnimation(DeltaTime);
-    if (CharacterMovement)
+    if (Enemy)
     {
-        GroundSpeed = UKismetMathLibrary::VSizeXY(CharacterMovement->Velocity);
-        IsFalling = CharacterMovement->IsFalling();
-        EnemyState = Enemy->GetEnemyState();
+        Enemy->PublishAnimSnapshot(Snapshot);
     }
 }
 
-
-
+void UEnemyAnimInstance::NativeThreadSafeUpdateAnimation(float DeltaTime)
+{
+    SCOPE_CYCLE_COUNTER(STAT_EnemyAnimThreadSafeUpdate);
+    Super::NativeThreadSafeUpdateAnimation(DeltaTime);
+    if (!IsInGameThread())
+        INC_DWORD_STAT(STAT_EnemyAnimUpdatesOffGameThread);
+    GroundSpeed = Snapshot.GroundSpeed;
+    IsFalling = Snapshot.bIsFalling;
+    EnemyState = Snapshot.EnemyState;
+}
@@ -2,5 +2,22 @@
 
 
 #include "Interfaces/HitInterface.h"
+#include "Interfaces/InterfaceDispatch.h"
 
 // Add default functionality here for any IHitInterface functions that are not pure virtual.
+
+void IHitInterface::DispatchGetHit(AActor* Actor, const FVector& ImpactPoint, AActor* Hitter)
+{
+	const InterfaceDispatch::FResolved Resolved = InterfaceDispatch::Resolve(Actor, UHitInterface::StaticClass(), GET_FUNCTION_NAME_CHECKED(IHitInterface, GetHit));
+	switch (Resolved.Dispatch)
+	{
+	case InterfaceDispatch::EDispatch::Native:
+		InterfaceDispatch::GetNative<IHitInterface>(Actor, Resolved)->GetHit_Implementation(ImpactPoint, Hitter);
+		break;
+	case InterfaceDispatch::EDispatch::Script:
+		Execute_GetHit(Actor, ImpactPoint, Hitter);
+		break;
+	default:
+		break;
+	}
+}
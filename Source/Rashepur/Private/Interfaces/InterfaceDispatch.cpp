@@ -0,0 +1,46 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Interfaces/InterfaceDispatch.h"
+#include "UObject/ObjectKey.h"
+
+namespace InterfaceDispatch
+{
+	/** Game thread only, like every caller of the interfaces */
+	static TMap<TTuple<TObjectKey<UClass>, FName>, FResolved> ResolvedClasses;
+
+	static FResolved ResolveClass(const UClass* Class, const UClass* InterfaceClass, FName FunctionName)
+	{
+		FResolved Resolved;
+		if (!Class->ImplementsInterface(InterfaceClass)) return Resolved;
+
+		// a Blueprint override wins over the native implementation, and Blueprint only implementers have no native address
+		Resolved.Dispatch = EDispatch::Script;
+		if (Class->IsFunctionImplementedInScript(FunctionName)) return Resolved;
+
+		for (const UClass* Current = Class; Current; Current = Current->GetSuperClass())
+		{
+			for (const FImplementedInterface& Implemented : Current->Interfaces)
+			{
+				if (Implemented.bImplementedByK2 || !Implemented.Class->IsChildOf(InterfaceClass)) continue;
+
+				Resolved.Dispatch = EDispatch::Native;
+				Resolved.PointerOffset = Implemented.PointerOffset;
+				return Resolved;
+			}
+		}
+		return Resolved;
+	}
+
+	FResolved Resolve(const UObject* Object, const UClass* InterfaceClass, FName FunctionName)
+	{
+		check(IsInGameThread());
+		if (Object == nullptr) return FResolved();
+
+		UClass* Class = Object->GetClass();
+		const TTuple<TObjectKey<UClass>, FName> Key(Class, FunctionName);
+		if (const FResolved* Cached = ResolvedClasses.Find(Key))
+			return *Cached;
+		return ResolvedClasses.Add(Key, ResolveClass(Class, InterfaceClass, FunctionName));
+	}
+}
@@ -0,0 +1,71 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Interfaces/HitInterface.h"
+#include "Interfaces/PickupInterface.h"
+#include "Breakable/BreakableActor.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+#if !UE_BUILD_SHIPPING
+
+namespace InterfaceDispatchBenchmark
+{
+	template <typename CallType>
+	static void Time(const TCHAR* Name, int32 NumCalls, CallType&& Call)
+	{
+		const double Start = FPlatformTime::Seconds();
+		for (int32 Index = 0; Index < NumCalls; ++Index)
+			Call();
+		const double Seconds = FPlatformTime::Seconds() - Start;
+
+		UE_LOG(LogTemp, Display, TEXT("%-28s %9d calls: %8.2f ns/call"), Name, NumCalls, Seconds * 1e9 / NumCalls);
+	}
+
+	static void Run(UWorld* World, int32 NumCalls)
+	{
+		if (World == nullptr) return;
+
+		// a native breakable with no treasure, broken by the first hit so every timed GetHit returns right away
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		ABreakableActor* Target = World->SpawnActor<ABreakableActor>(ABreakableActor::StaticClass(), FTransform::Identity, SpawnParams);
+		if (Target == nullptr) return;
+		Target->SetActorHiddenInGame(true);
+		Target->SetActorEnableCollision(false);
+		IHitInterface::DispatchGetHit(Target, FVector::ZeroVector, nullptr);
+
+		Time(TEXT("GetHit Cast + Execute_"), NumCalls, [Target]()
+		{
+			if (Cast<IHitInterface>(Target))
+				IHitInterface::Execute_GetHit(Target, FVector::ZeroVector, nullptr);
+		});
+		Time(TEXT("GetHit Dispatch"), NumCalls, [Target]()
+		{
+			IHitInterface::DispatchGetHit(Target, FVector::ZeroVector, nullptr);
+		});
+
+		// what an item overlap costs for an actor that picks nothing up
+		Time(TEXT("Pickup miss Cast"), NumCalls, [Target]()
+		{
+			if (IPickupInterface* PickupInterface = Cast<IPickupInterface>(Target))
+				IPickupInterface::Execute_SetOverlappingItem(Target, nullptr);
+		});
+		Time(TEXT("Pickup miss Dispatch"), NumCalls, [Target]()
+		{
+			IPickupInterface::DispatchSetOverlappingItem(Target, nullptr);
+		});
+
+		Target->Destroy();
+	}
+
+	static FAutoConsoleCommandWithWorldAndArgs BenchCommand(
+		TEXT("Rashepur.Combat.BenchInterfaceDispatch"),
+		TEXT("Rashepur.Combat.BenchInterfaceDispatch [Calls] - times GetHit and pickup dispatch through Execute_ and through the native fast path"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			Run(World, Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 1000000);
+		}));
+}
+
+#endif
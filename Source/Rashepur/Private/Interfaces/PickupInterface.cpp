@@ -2,13 +2,46 @@
 
 
 #include "Interfaces/PickupInterface.h"
+#include "Interfaces/InterfaceDispatch.h"
 
 // Add default functionality here for any IPickupInterface functions that are not pure virtual.
 
-void IPickupInterface::SetOverlappingItem(AItem* Item)
+void IPickupInterface::SetOverlappingItem_Implementation(AItem* Item)
 {
 }
 
-void IPickupInterface::AddSouls(ASoul* Soul)
+void IPickupInterface::AddSouls_Implementation(ASoul* Soul)
 {
 }
+
+void IPickupInterface::DispatchSetOverlappingItem(AActor* Actor, AItem* Item)
+{
+	const InterfaceDispatch::FResolved Resolved = InterfaceDispatch::Resolve(Actor, UPickupInterface::StaticClass(), GET_FUNCTION_NAME_CHECKED(IPickupInterface, SetOverlappingItem));
+	switch (Resolved.Dispatch)
+	{
+	case InterfaceDispatch::EDispatch::Native:
+		InterfaceDispatch::GetNative<IPickupInterface>(Actor, Resolved)->SetOverlappingItem_Implementation(Item);
+		break;
+	case InterfaceDispatch::EDispatch::Script:
+		Execute_SetOverlappingItem(Actor, Item);
+		break;
+	default:
+		break;
+	}
+}
+
+void IPickupInterface::DispatchAddSouls(AActor* Actor, ASoul* Soul)
+{
+	const InterfaceDispatch::FResolved Resolved = InterfaceDispatch::Resolve(Actor, UPickupInterface::StaticClass(), GET_FUNCTION_NAME_CHECKED(IPickupInterface, AddSouls));
+	switch (Resolved.Dispatch)
+	{
+	case InterfaceDispatch::EDispatch::Native:
+		InterfaceDispatch::GetNative<IPickupInterface>(Actor, Resolved)->AddSouls_Implementation(Soul);
+		break;
+	case InterfaceDispatch::EDispatch::Script:
+		Execute_AddSouls(Actor, Soul);
+		break;
+	default:
+		break;
+	}
+}
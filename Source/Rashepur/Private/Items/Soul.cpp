@@ -5,10 +5,6 @@
 
 void ASoul::OnSphereOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
 {
-	IPickupInterface* PickupInterface = Cast<IPickupInterface>(OtherActor);
-	if (PickupInterface)
-	{
-		PickupInterface->AddSouls(this);
-	}
+	IPickupInterface::DispatchAddSouls(OtherActor, this);
 	Destroy();	
 }
@@ -0,0 +1,140 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Spatial/GameplayTraceScheduler.h"
+#include "Rashepur.h"
+#include "Engine/World.h"
+#include "Algo/StableSort.h"
+
+DECLARE_CYCLE_STAT(TEXT("Trace Scheduler Submit"), STAT_TraceSchedulerSubmit, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Traces Requested"), STAT_TracesRequested, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Traces Batch Size"), STAT_TracesBatchSize, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Traces Deferred"), STAT_TracesDeferred, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Traces Same Frame"), STAT_TracesSameFrame, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Trace Max Latency (frames)"), STAT_TraceMaxLatency, STATGROUP_Rashepur);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Trace Latency Sum (frames)"), STAT_TraceLatencySum, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Traces Completed"), STAT_TracesCompleted, STATGROUP_Rashepur);
+
+void UGameplayTraceScheduler::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	TraceDelegate.BindUObject(this, &UGameplayTraceScheduler::OnTraceCompleted);
+}
+
+void UGameplayTraceScheduler::Deinitialize()
+{
+	TraceDelegate.Unbind();
+	Queue.Empty();
+	Deferred.Empty();
+	InFlight.Empty();
+	Super::Deinitialize();
+}
+
+bool UGameplayTraceScheduler::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UGameplayTraceScheduler::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UGameplayTraceScheduler, STATGROUP_Tickables);
+}
+
+void UGameplayTraceScheduler::RequestTrace(const FGameplayTraceRequest& Request, FOnGameplayTraceCompleted OnCompleted)
+{
+	FQueuedTrace& Queued = Queue.AddDefaulted_GetRef();
+	Queued.Request = Request;
+	Queued.OnCompleted = MoveTemp(OnCompleted);
+	Queued.RequestFrame = GFrameCounter;
+	INC_DWORD_STAT(STAT_TracesRequested);
+}
+
+bool UGameplayTraceScheduler::TraceNow(const FGameplayTraceRequest& Request, TArray<FHitResult>& OutHits) const
+{
+	INC_DWORD_STAT(STAT_TracesSameFrame);
+	const UWorld* World = GetWorld();
+	const FGameplayTraceRequest& R = Request;
+	if (R.bMulti)
+	{
+		if (R.Shape.IsLine())
+			return World->LineTraceMultiByChannel(OutHits, R.Start, R.End, R.Channel, R.Params, R.ResponseParams);
+		return World->SweepMultiByChannel(OutHits, R.Start, R.End, R.Rotation, R.Channel, R.Shape, R.Params, R.ResponseParams);
+	}
+
+	FHitResult Hit;
+	const bool bBlocked = R.Shape.IsLine()
+		? World->LineTraceSingleByChannel(Hit, R.Start, R.End, R.Channel, R.Params, R.ResponseParams)
+		: World->SweepSingleByChannel(Hit, R.Start, R.End, R.Rotation, R.Channel, R.Shape, R.Params, R.ResponseParams);
+	if (bBlocked)
+		OutHits.Add(Hit);
+	return bBlocked;
+}
+
+void UGameplayTraceScheduler::Tick(float DeltaTime)
+{
+	// last frame's results were delivered before the world ticked
+	SET_DWORD_STAT(STAT_TraceMaxLatency, MaxLatency);
+	MaxLatency = 0;
+	SubmitBatch();
+}
+
+void UGameplayTraceScheduler::SubmitBatch()
+{
+	SCOPE_CYCLE_COUNTER(STAT_TraceSchedulerSubmit);
+	if (Queue.Num() == 0) return;
+
+	// stable so requests of equal priority keep their order and the oldest go first
+	Algo::StableSortBy(Queue, [](const FQueuedTrace& Queued) { return Queued.Request.Priority; });
+
+	int32 BatchSize = 0;
+	Deferred.Reset();
+	for (FQueuedTrace& Queued : Queue)
+	{
+		const bool bOverdue = GFrameCounter - Queued.RequestFrame >= Queued.Request.MaxDelayFrames;
+		if (BatchSize < MaxTracesPerFrame || bOverdue || Queued.Request.Priority == EGameplayTracePriority::Critical)
+		{
+			Submit(Queued);
+			++BatchSize;
+		}
+		else
+			Deferred.Add(MoveTemp(Queued));
+	}
+	Swap(Queue, Deferred);
+	Deferred.Reset();
+
+	SET_DWORD_STAT(STAT_TracesBatchSize, BatchSize);
+	SET_DWORD_STAT(STAT_TracesDeferred, Queue.Num());
+}
+
+void UGameplayTraceScheduler::Submit(FQueuedTrace& Queued)
+{
+	FInFlightTrace InFlightTrace;
+	InFlightTrace.OnCompleted = MoveTemp(Queued.OnCompleted);
+	InFlightTrace.RequestFrame = Queued.RequestFrame;
+	const uint32 UserData = (uint32)InFlight.Add(MoveTemp(InFlightTrace));
+
+	UWorld* World = GetWorld();
+	const FGameplayTraceRequest& R = Queued.Request;
+	const EAsyncTraceType TraceType = R.bMulti ? EAsyncTraceType::Multi : EAsyncTraceType::Single;
+	if (R.Shape.IsLine())
+		World->AsyncLineTraceByChannel(TraceType, R.Start, R.End, R.Channel, R.Params, R.ResponseParams, &TraceDelegate, UserData);
+	else
+		World->AsyncSweepByChannel(TraceType, R.Start, R.End, R.Rotation, R.Channel, R.Shape, R.Params, R.ResponseParams, &TraceDelegate, UserData);
+}
+
+void UGameplayTraceScheduler::OnTraceCompleted(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum)
+{
+	const int32 Index = (int32)TraceDatum.UserData;
+	if (!InFlight.IsValidIndex(Index)) return;
+
+	// moved out first, the callback may queue the next trace and grow InFlight
+	FInFlightTrace Completed = MoveTemp(InFlight[Index]);
+	InFlight.RemoveAt(Index);
+
+	const uint32 Latency = (uint32)(GFrameCounter - Completed.RequestFrame);
+	INC_DWORD_STAT(STAT_TracesCompleted);
+	INC_FLOAT_STAT_BY(STAT_TraceLatencySum, (float)Latency);
+	MaxLatency = FMath::Max(MaxLatency, Latency);
+
+	Completed.OnCompleted.ExecuteIfBound(TraceDatum.OutHits);
+}
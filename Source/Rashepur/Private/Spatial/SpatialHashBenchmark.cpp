@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Spatial/SpatialHashSubsystem.h"
+#include "Enemy/Enemy.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+
+#if !UE_BUILD_SHIPPING
+
+namespace SpatialHashBenchmark
+{
+	template <typename QueryType>
+	static void Time(const TCHAR* Name, int32 NumQueries, QueryType&& Query)
+	{
+		int32 NumFound = 0;
+		const double Start = FPlatformTime::Seconds();
+		for (int32 Index = 0; Index < NumQueries; ++Index)
+			NumFound = Query();
+		const double Seconds = FPlatformTime::Seconds() - Start;
+
+		UE_LOG(LogTemp, Display, TEXT("%-28s %6d found: %10.2f us/query"), Name, NumFound, Seconds * 1e6 / NumQueries);
+	}
+
+	/** The sensing gate's query around the hero against the per enemy distance checks it saves and a physics sphere overlap */
+	static void Run(UWorld* World, double Radius, int32 NumQueries)
+	{
+		const USpatialHashSubsystem* SpatialHash = World ? World->GetSubsystem<USpatialHashSubsystem>() : nullptr;
+		const APlayerController* PlayerController = World ? World->GetFirstPlayerController() : nullptr;
+		const APawn* Hero = PlayerController ? PlayerController->GetPawn() : nullptr;
+		if (SpatialHash == nullptr || Hero == nullptr || NumQueries <= 0) return;
+
+		const FVector Center = Hero->GetActorLocation();
+		const double RadiusSquared = Radius * Radius;
+
+		Time(TEXT("Spatial hash ForEachInRadius"), NumQueries, [SpatialHash, &Center, Radius]()
+		{
+			int32 NumFound = 0;
+			SpatialHash->ForEachInRadius(Center, Radius, ESpatialCategory::Enemy, [&NumFound](AActor*, double) { ++NumFound; });
+			return NumFound;
+		});
+		Time(TEXT("Every enemy distance check"), NumQueries, [World, &Center, RadiusSquared]()
+		{
+			int32 NumFound = 0;
+			for (TActorIterator<AEnemy> It(World); It; ++It)
+			{
+				if (FVector::DistSquared(It->GetActorLocation(), Center) <= RadiusSquared)
+					++NumFound;
+			}
+			return NumFound;
+		});
+		Time(TEXT("Physics sphere overlap"), NumQueries, [World, &Center, Radius]()
+		{
+			TArray<FOverlapResult> Overlaps;
+			World->OverlapMultiByObjectType(Overlaps, Center, FQuat::Identity, FCollisionObjectQueryParams(ECollisionChannel::ECC_Pawn), FCollisionShape::MakeSphere(Radius));
+			int32 NumFound = 0;
+			for (const FOverlapResult& Overlap : Overlaps)
+			{
+				if (Cast<AEnemy>(Overlap.GetActor()))
+					++NumFound;
+			}
+			return NumFound;
+		});
+	}
+
+	static FAutoConsoleCommandWithWorldAndArgs BenchCommand(
+		TEXT("Rashepur.Spatial.BenchRadiusQuery"),
+		TEXT("Rashepur.Spatial.BenchRadiusQuery [Radius] [Queries] - times the enemies around the hero through the spatial hash, a scan of every enemy and a sphere overlap"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			Run(World, Args.Num() > 0 ? FCString::Atod(*Args[0]) : 3100.0, Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 10000);
+		}));
+}
+
+#endif
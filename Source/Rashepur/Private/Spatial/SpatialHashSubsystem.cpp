@@ -0,0 +1,143 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Spatial/SpatialHashSubsystem.h"
+#include "Components/SceneComponent.h"
+
+DEFINE_STAT(STAT_SpatialHashQuery);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Spatial Hash Queries"), STAT_SpatialHashQueries, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Spatial Hash Cells Visited"), STAT_SpatialHashCellsVisited, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Spatial Hash Entries Tested"), STAT_SpatialHashEntriesTested, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Spatial Hash Rebuckets"), STAT_SpatialHashRebuckets, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Spatial Hash Entries"), STAT_SpatialHashEntries, STATGROUP_Rashepur);
+
+void USpatialHashSubsystem::Deinitialize()
+{
+	for (const FEntry& Entry : Entries)
+	{
+		if (AActor* Actor = Entry.Actor.Get())
+		{
+			if (USceneComponent* Root = Actor->GetRootComponent())
+				Root->TransformUpdated.RemoveAll(this);
+			Actor->OnEndPlay.RemoveDynamic(this, &USpatialHashSubsystem::OnActorEndPlay);
+		}
+	}
+	Entries.Empty();
+	EntryIndices.Empty();
+	Cells.Empty();
+	Super::Deinitialize();
+}
+
+bool USpatialHashSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void USpatialHashSubsystem::Register(AActor* Actor, uint8 Category)
+{
+	if (Actor == nullptr || Actor->GetRootComponent() == nullptr) return;
+
+	if (const int32* ExistingIndex = EntryIndices.Find(Actor))
+	{
+		Entries[*ExistingIndex].Category |= Category;
+		return;
+	}
+
+	FEntry Entry;
+	Entry.Actor = Actor;
+	Entry.Key = Actor;
+	Entry.Location = Actor->GetActorLocation();
+	Entry.Cell = ToCell(Entry.Location);
+	Entry.Category = Category;
+
+	const int32 EntryIndex = Entries.Add(Entry);
+	EntryIndices.Add(Actor, EntryIndex);
+	AddToCell(Entry.Cell, EntryIndex);
+	Actor->GetRootComponent()->TransformUpdated.AddUObject(this, &USpatialHashSubsystem::OnTransformUpdated);
+	Actor->OnEndPlay.AddDynamic(this, &USpatialHashSubsystem::OnActorEndPlay);
+	SET_DWORD_STAT(STAT_SpatialHashEntries, Entries.Num());
+}
+
+void USpatialHashSubsystem::Unregister(AActor* Actor)
+{
+	int32 EntryIndex = INDEX_NONE;
+	if (Actor && EntryIndices.RemoveAndCopyValue(Actor, EntryIndex))
+	{
+		if (USceneComponent* Root = Actor->GetRootComponent())
+			Root->TransformUpdated.RemoveAll(this);
+		Actor->OnEndPlay.RemoveDynamic(this, &USpatialHashSubsystem::OnActorEndPlay);
+		RemoveEntry(EntryIndex);
+	}
+	SET_DWORD_STAT(STAT_SpatialHashEntries, Entries.Num());
+}
+
+void USpatialHashSubsystem::OnActorEndPlay(AActor* Actor, EEndPlayReason::Type EndPlayReason)
+{
+	Unregister(Actor);
+}
+
+void USpatialHashSubsystem::RemoveEntry(int32 EntryIndex)
+{
+	RemoveFromCell(Entries[EntryIndex].Cell, EntryIndex);
+
+	const int32 LastIndex = Entries.Num() - 1;
+	if (EntryIndex != LastIndex)
+	{
+		// the last entry takes the freed slot, point its cell and lookup at the new index
+		const FEntry& Moved = Entries[LastIndex];
+		if (FCellEntries* Cell = Cells.Find(Moved.Cell))
+		{
+			const int32 SlotInCell = Cell->Find(LastIndex);
+			if (SlotInCell != INDEX_NONE)
+				(*Cell)[SlotInCell] = EntryIndex;
+		}
+		if (int32* MovedIndex = EntryIndices.Find(Moved.Key))
+			*MovedIndex = EntryIndex;
+	}
+	Entries.RemoveAtSwap(EntryIndex, 1, false);
+}
+
+void USpatialHashSubsystem::OnTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+	const int32* EntryIndex = UpdatedComponent ? EntryIndices.Find(UpdatedComponent->GetOwner()) : nullptr;
+	if (EntryIndex == nullptr) return;
+
+	FEntry& Entry = Entries[*EntryIndex];
+	Entry.Location = UpdatedComponent->GetComponentLocation();
+
+	const FIntVector NewCell = ToCell(Entry.Location);
+	if (NewCell != Entry.Cell)
+	{
+		RemoveFromCell(Entry.Cell, *EntryIndex);
+		Entry.Cell = NewCell;
+		AddToCell(NewCell, *EntryIndex);
+		INC_DWORD_STAT(STAT_SpatialHashRebuckets);
+	}
+}
+
+FIntVector USpatialHashSubsystem::ToCell(const FVector& Location) const
+{
+	return FIntVector(
+		FMath::FloorToInt32(Location.X / CellSize),
+		FMath::FloorToInt32(Location.Y / CellSize),
+		FMath::FloorToInt32(Location.Z / CellSize));
+}
+
+void USpatialHashSubsystem::AddToCell(const FIntVector& Cell, int32 EntryIndex)
+{
+	Cells.FindOrAdd(Cell).Add(EntryIndex);
+}
+
+void USpatialHashSubsystem::RemoveFromCell(const FIntVector& Cell, int32 EntryIndex)
+{
+	// empty cells are kept, their inline storage is reused when someone walks back in
+	if (FCellEntries* CellEntries = Cells.Find(Cell))
+		CellEntries->RemoveSingleSwap(EntryIndex, false);
+}
+
+void USpatialHashSubsystem::RecordQuery(int32 CellsVisited, int32 EntriesTested) const
+{
+	INC_DWORD_STAT(STAT_SpatialHashQueries);
+	INC_DWORD_STAT_BY(STAT_SpatialHashCellsVisited, CellsVisited);
+	INC_DWORD_STAT_BY(STAT_SpatialHashEntriesTested, EntriesTested);
+}
@@ -0,0 +1,176 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CharacterStates.h"
+#include "AI/EnemyAITypes.h"
+#include "AI/EnemyRangeKernel.h"
+#include "EnemyAIManager.generated.h"
+
+class AEnemy;
+
+/**
+ * Owns every registered AEnemy and runs their combat/patrol decisions in a single pass per frame.
+ * Hot decision state is mirrored into contiguous arrays (one entry per enemy, same index in every array),
+ * so the decision loop never touches actor memory. Enemies only apply the resulting decision.
+ * Enemies are also ranked by significance to the hero; far, unseen patrollers decide, sense and move at lower rates.
+ * Enemies that only wait on events (patrolling, staggered, dead) are kept past NumActive and skipped by every pass.
+ */
+UCLASS(Config = Game)
+class RASHEPUR_API UEnemyAIManager : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** <UTickableWorldSubsystem> */
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	/** </UTickableWorldSubsystem> */
+
+	void RegisterEnemy(AEnemy* Enemy);
+	void UnregisterEnemy(AEnemy* Enemy);
+
+	/** Moves the enemy in or out of the decision passes, called whenever its state changes */
+	void SetEnemyActive(AEnemy* Enemy, bool bActive);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	friend struct FEnemyDormancySoak;
+
+	void UpdateSignificance(float DeltaTime);
+	/**
+	 * Sets every enemy's anim tick rate from its tier, then slows the least significant idle ones until the estimate fits AnimBudgetMs.
+	 * Pose followers cost nothing and are left out; a leader runs at the fastest rate of its group and is ranked by its most significant member.
+	 */
+	void UpdateAnimBudget();
+	/** Turns PawnSensing off for patrollers the hero is out of sight range of, found with one spatial hash query around the hero */
+	void UpdateSensingGate(const FVector& HeroLocation);
+	int32 SelectLODTier(double SignificanceDistSquared) const;
+	void GatherEnemyState(float DeltaTime);
+	void ComputeRangeFlags();
+	void QueryVisibility();
+	void RunDecisionPass();
+	FEnemyRangeKernelInput MakeRangeKernelInput(int32 Start, int32 Count) const;
+	/** Rashepur.AI.VerifyParallelDecide, replays the range and decision passes serially from the gathered flags and logs every enemy whose flag byte or decision differs */
+	void VerifyParallelPasses();
+	void ApplyDecisions();
+
+	int32 FindOrAddFrameTarget(APawn* Target);
+	void RemoveEnemyAtSwap(int32 Index);
+	void SwapEnemies(int32 IndexA, int32 IndexB);
+
+	/** Calls ChunkBody(Start, End) over the active enemies, in parallel when Rashepur.AI.ParallelDecide is set */
+	template<typename ChunkBodyType>
+	void ForEachActiveChunk(ChunkBodyType&& ChunkBody) const;
+
+	void SetLODTier(int32 Index, int32 TierIndex);
+
+	/**
+	 * Registered enemies and their mirrored hot state
+	 */
+	UPROPERTY()
+	TArray<TObjectPtr<AEnemy>> Enemies;
+
+	TArray<EEnemyState> EnemyStates;
+	TArray<EActionState> ActionStates;
+	TArray<int32> CombatTargetIndices;
+
+	/** Positions split per axis so the range kernel can load four enemies at once */
+	TArray<float> EnemyX;
+	TArray<float> EnemyY;
+	TArray<float> EnemyZ;
+	TArray<float> TargetX;
+	TArray<float> TargetY;
+	TArray<float> TargetZ;
+	TArray<float> PatrolX;
+	TArray<float> PatrolY;
+	TArray<float> PatrolZ;
+	TArray<float> CombatRadiusSquared;
+	TArray<float> AttackRadiusSquared;
+	TArray<float> PatrolRadiusSquared;
+	TArray<float> DecisionTimers;
+	TArray<uint8> LODTiers;
+	TArray<uint8> AnimTickRates;
+	/** Offscreen scaled squared distance to the hero from the last significance update, negative while fighting */
+	TArray<float> SignificanceDistances;
+	TArray<uint8> SensingEnabled;
+	TArray<uint8> Flags;
+	TArray<EEnemyAIDecision> Decisions;
+
+	/** Flags as gathered before the range pass and the serial replay's, only filled while Rashepur.AI.VerifyParallelDecide is set */
+	TArray<uint8> VerifyGatheredFlags;
+	TArray<uint8> VerifyFlags;
+
+	/** Enemies [0, NumActive) run the decision passes, the rest are dormant until an event wakes them */
+	int32 NumActive = 0;
+
+	/** State changes made while decisions are applied, re-sorted once the apply loop is done */
+	UPROPERTY()
+	TArray<TObjectPtr<AEnemy>> PendingActivityChanges;
+
+	bool bApplyingDecisions = false;
+
+	/**
+	 * Combat targets referenced this frame, so a shared target (the hero) is looked up once
+	 */
+	UPROPERTY()
+	TArray<TObjectPtr<APawn>> FrameTargets;
+
+	TArray<FVector> FrameTargetLocations;
+	TArray<bool> FrameTargetDead;
+
+	/**
+	 * Significance
+	 */
+
+	/** Ordered from nearest to farthest, the last tier catches everything beyond the others */
+	UPROPERTY(EditAnywhere, Config, Category = "Significance")
+	TArray<FEnemyAILODTier> LODTierSettings;
+
+	/** Off screen enemies are ranked as if they were this many times farther away */
+	UPROPERTY(EditAnywhere, Config, Category = "Significance")
+	float OffscreenDistanceScale = 2.f;
+
+	UPROPERTY(EditAnywhere, Config, Category = "Significance")
+	float SignificanceUpdateInterval = 0.25f;
+
+	float SignificanceTimer = 0.f;
+
+	/** Added to the largest SightRadius, the hero keeps moving between significance updates */
+	UPROPERTY(EditAnywhere, Config, Category = "Significance")
+	float SensingGateMargin = 500.f;
+
+	/** Largest SightRadius of any registered enemy, the radius of the sensing gate query */
+	float MaxSightRadius = 0.f;
+
+	/** Scratch for UpdateSensingGate */
+	TArray<uint8> SensingInRange;
+
+	/**
+	 * Animation budget
+	 */
+
+	/** Game thread milliseconds per frame the enemies' anim graphs may take, as estimated with EstimatedAnimMsPerEnemy */
+	UPROPERTY(EditAnywhere, Config, Category = "Animation Budget")
+	float AnimBudgetMs = 2.f;
+
+	/** Cost of one full rate enemy anim update, measure with stat anim on the target hardware */
+	UPROPERTY(EditAnywhere, Config, Category = "Animation Budget")
+	float EstimatedAnimMsPerEnemy = 0.03f;
+
+	/** Slowest rate the budget drops to, URO only interpolates skipped frames below its MaxEvalRateForInterpolation (4) so slower rates pop */
+	UPROPERTY(EditAnywhere, Config, Category = "Animation Budget")
+	int32 MaxAnimTickRate = 3;
+
+	/** Scratch for UpdateAnimBudget */
+	TArray<int32> AnimBudgetOrder;
+	TArray<uint8> AnimTargetRates;
+	TArray<int32> AnimLeaderIndices;
+	TArray<float> AnimBudgetPriorities;
+};
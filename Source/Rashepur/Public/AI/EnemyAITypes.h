@@ -0,0 +1,40 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AI/EnemyDecisionCore.h"
+#include "EnemyAITypes.generated.h"
+
+/** Result of the enemy AI manager decision pass, applied by the enemy actor */
+using EEnemyAIDecision = EnemyDecisionCore::EDecision;
+
+/** Per enemy bits filled by the manager before deciding */
+namespace EnemyAIFlags = EnemyDecisionCore::Flags;
+
+/** Significance tier, enemies are placed in the first tier whose MaxDistance covers them */
+USTRUCT()
+struct FEnemyAILODTier
+{
+	GENERATED_BODY()
+
+	/** Distance to the hero (scaled when the enemy is off screen) covered by this tier */
+	UPROPERTY(EditAnywhere, Config)
+	float MaxDistance = 0.f;
+
+	/** Seconds between decision passes, 0 decides every frame */
+	UPROPERTY(EditAnywhere, Config)
+	float DecisionInterval = 0.f;
+
+	/** PawnSensing interval, 0 keeps the value authored on the enemy */
+	UPROPERTY(EditAnywhere, Config)
+	float SensingInterval = 0.f;
+
+	/** CharacterMovement tick interval, 0 ticks every frame */
+	UPROPERTY(EditAnywhere, Config)
+	float MovementTickInterval = 0.f;
+
+	/** Frames between anim graph evaluations, 1 evaluates every frame; the animation budget may raise it further */
+	UPROPERTY(EditAnywhere, Config)
+	int32 AnimTickRate = 1;
+};
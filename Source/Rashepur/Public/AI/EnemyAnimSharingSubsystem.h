@@ -0,0 +1,66 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "EnemyAnimSharingSubsystem.generated.h"
+
+class AEnemy;
+class USkeletalMesh;
+
+/** Calm states whose pose is the same for every enemy of an archetype, anything else evaluates its own graph */
+enum class EEnemyAnimShareState : uint8
+{
+	None,
+	PatrolWalk,
+	Idle,
+	LookAround
+};
+
+/**
+ * Lets enemies of one archetype (skeletal mesh and anim class) in the same calm state follow a single leader pose.
+ * The first enemy to enter a state leads it and evaluates its graph as usual; the rest copy its bones through
+ * SetLeaderPoseComponent and skip their own evaluation, so anim cost grows with archetypes times states instead of enemies.
+ * Enemies leave as soon as their state changes, which covers entering combat, hit reacts (Staggered) and death.
+ */
+UCLASS()
+class RASHEPUR_API UEnemyAnimSharingSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** <UWorldSubsystem> */
+	virtual void Deinitialize() override;
+	/** </UWorldSubsystem> */
+
+	/** Moves Enemy to the group of NewState, None gives it back its own evaluation */
+	void SetShareState(AEnemy* Enemy, EEnemyAnimShareState NewState);
+
+	/** Leader of the group Enemy is in, Enemy itself when it leads, nullptr when it evaluates its own pose */
+	AEnemy* GetLeader(const AEnemy* Enemy) const;
+
+	static bool IsEnabled();
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FShareGroup
+	{
+		TWeakObjectPtr<AEnemy> Leader;
+		TArray<TWeakObjectPtr<AEnemy>> Followers;
+	};
+
+	/** Skeletal mesh, anim class, state */
+	using FShareKey = TTuple<TObjectKey<USkeletalMesh>, TObjectKey<UClass>, EEnemyAnimShareState>;
+
+	static FShareKey MakeKey(const AEnemy* Enemy, EEnemyAnimShareState State);
+	void Join(AEnemy* Enemy, EEnemyAnimShareState State);
+	void Leave(AEnemy* Enemy, EEnemyAnimShareState State);
+	static void Follow(AEnemy* Follower, AEnemy* Leader);
+	static void SetLeading(AEnemy* Enemy, bool bLeading);
+
+	TMap<FShareKey, FShareGroup> Groups;
+};
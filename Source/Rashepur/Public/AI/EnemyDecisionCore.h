@@ -0,0 +1,171 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <cstdint>
+
+/**
+ * The enemy decision rules as plain constexpr functions over plain values, with no engine or UObject dependency.
+ * UEnemyAIManager and AEnemy translate their state into these types and call in; the same header compiles on its own,
+ * so the rules are tested and benchmarked without a world by the RashepurDecisionCoreTests program.
+ */
+namespace EnemyDecisionCore
+{
+	/** Same order as EEnemyState, checked where the two meet */
+	enum class EState : uint8_t
+	{
+		Staggered,
+		Dead,
+		Patrolling,
+		Chasing,
+		Searching,
+		Engaged,
+		NoState
+	};
+
+	/** Same order as EActionState, checked where the two meet */
+	enum class EAction : uint8_t
+	{
+		Unoccupied,
+		HitReaction,
+		Occupied,
+		PerformingAction,
+		Attacking
+	};
+
+	/** Result of a decision, applied by the enemy actor */
+	enum class EDecision : uint8_t
+	{
+		EAD_None,
+		EAD_ReachedPatrolTarget,
+		EAD_LoseInterest,
+		EAD_Chase,
+		EAD_Search,
+		EAD_Engage,
+		EAD_CombatTargetDead
+	};
+
+	/** Per enemy bits filled before deciding */
+	namespace Flags
+	{
+		constexpr uint8_t HasCombatTarget = 1 << 0;
+		constexpr uint8_t InCombatRadius = 1 << 1;
+		constexpr uint8_t InAttackRadius = 1 << 2;
+		constexpr uint8_t HasPatrolTarget = 1 << 3;
+		constexpr uint8_t InPatrolRadius = 1 << 4;
+		constexpr uint8_t CanSeeTarget = 1 << 5;
+		constexpr uint8_t CombatTargetDead = 1 << 6;
+		constexpr uint8_t DecisionDue = 1 << 7;
+	}
+
+	/** State bits packed above the per enemy flags, so every predicate is one mask test */
+	namespace Masks
+	{
+		constexpr uint32_t Attacking = 1 << 8;
+		constexpr uint32_t Chasing = 1 << 9;
+		constexpr uint32_t Searching = 1 << 10;
+		constexpr uint32_t Engaged = 1 << 11;
+		constexpr uint32_t Patrolling = 1 << 12;
+
+		struct FPredicate
+		{
+			uint32_t Require;
+			uint32_t Forbid;
+
+			constexpr bool Test(uint32_t Mask) const { return (Mask & (Require | Forbid)) == Require; }
+		};
+
+		constexpr FPredicate CanChase{
+			Flags::InCombatRadius | Flags::CanSeeTarget,
+			Flags::InAttackRadius | Chasing | Searching };
+		constexpr FPredicate CanSearch{
+			Flags::InCombatRadius,
+			Flags::CanSeeTarget | Attacking | Searching };
+		constexpr FPredicate CanEngage{
+			Flags::InCombatRadius | Flags::InAttackRadius | Flags::CanSeeTarget,
+			Engaged | Attacking | Searching };
+		constexpr FPredicate TargetDead{
+			Flags::CombatTargetDead,
+			Patrolling };
+	}
+
+	/** Keeps the band bits whose owning target bit is set */
+	constexpr uint8_t MaskByTargets(uint8_t EnemyFlags, uint8_t BandBits)
+	{
+		const uint8_t CombatMask = (EnemyFlags & Flags::HasCombatTarget) ? (Flags::InCombatRadius | Flags::InAttackRadius) : 0;
+		const uint8_t PatrolMask = (EnemyFlags & Flags::HasPatrolTarget) ? Flags::InPatrolRadius : 0;
+		return BandBits & (CombatMask | PatrolMask);
+	}
+
+	/** CombatRadius, AttackRadius and PatrolRadius bands from squared distances, masked by the target bits in EnemyFlags */
+	constexpr uint8_t RangeBits(uint8_t EnemyFlags, float TargetDistSquared, float PatrolDistSquared,
+		float CombatRadiusSquared, float AttackRadiusSquared, float PatrolRadiusSquared)
+	{
+		const uint8_t BandBits =
+			(TargetDistSquared <= CombatRadiusSquared ? Flags::InCombatRadius : 0) |
+			(TargetDistSquared <= AttackRadiusSquared ? Flags::InAttackRadius : 0) |
+			(PatrolDistSquared <= PatrolRadiusSquared ? Flags::InPatrolRadius : 0);
+		return MaskByTargets(EnemyFlags, BandBits);
+	}
+
+	/** What an enemy in a combat state (above Patrolling) does next */
+	constexpr EDecision DecideCombat(EState State, EAction Action, uint8_t EnemyFlags)
+	{
+		using namespace Masks;
+
+		if (!(EnemyFlags & Flags::InCombatRadius))
+			return EDecision::EAD_LoseInterest;
+
+		const uint32_t Mask = EnemyFlags |
+			(Action == EAction::Attacking ? Attacking : 0) |
+			(State == EState::Chasing ? Chasing : 0) |
+			(State == EState::Searching ? Searching : 0) |
+			(State == EState::Engaged ? Engaged : 0) |
+			(State == EState::Patrolling ? Patrolling : 0);
+
+		if (CanChase.Test(Mask))
+			return EDecision::EAD_Chase;
+		if (CanSearch.Test(Mask))
+			return EDecision::EAD_Search;
+		if (CanEngage.Test(Mask))
+			return EDecision::EAD_Engage;
+		if (TargetDead.Test(Mask))
+			return EDecision::EAD_CombatTargetDead;
+		return EDecision::EAD_None;
+	}
+
+	/** Full decision for one enemy, EnemyFlags already holds the range and visibility bits */
+	constexpr EDecision Decide(EState State, EAction Action, uint8_t EnemyFlags)
+	{
+		if (!(EnemyFlags & Flags::DecisionDue))
+			return EDecision::EAD_None;
+		if (State == EState::Dead || State == EState::Staggered)
+			return EDecision::EAD_None;
+		if (State > EState::Patrolling)
+			return DecideCombat(State, Action, EnemyFlags);
+		if (EnemyFlags & Flags::InPatrolRadius)
+			return EDecision::EAD_ReachedPatrolTarget;
+		return EDecision::EAD_None;
+	}
+
+	/** How many patrol points can be picked next, every point but the current one (INDEX_NONE style -1 when off route) */
+	constexpr int32_t NumPatrolCandidates(int32_t NumPoints, int32_t CurrentIndex)
+	{
+		return CurrentIndex < 0 ? NumPoints : NumPoints - 1;
+	}
+
+	/** Maps a candidate in [0, NumPatrolCandidates) to a patrol point index, skipping CurrentIndex */
+	constexpr int32_t PatrolIndexFromCandidate(int32_t Candidate, int32_t CurrentIndex)
+	{
+		return (CurrentIndex >= 0 && Candidate >= CurrentIndex) ? Candidate + 1 : Candidate;
+	}
+
+	static_assert(Decide(EState::Chasing, EAction::Unoccupied, Flags::DecisionDue) == EDecision::EAD_LoseInterest, "Leaving the combat radius loses interest");
+	static_assert(Decide(EState::NoState, EAction::Unoccupied, Flags::DecisionDue | Flags::InCombatRadius | Flags::CanSeeTarget) == EDecision::EAD_Chase, "A visible target in range is chased");
+	static_assert(Decide(EState::Chasing, EAction::Unoccupied, Flags::DecisionDue | Flags::InCombatRadius) == EDecision::EAD_Search, "A lost target is searched for");
+	static_assert(Decide(EState::Chasing, EAction::Unoccupied, Flags::DecisionDue | Flags::InCombatRadius | Flags::InAttackRadius | Flags::CanSeeTarget) == EDecision::EAD_Engage, "A visible target in attack range is engaged");
+	static_assert(Decide(EState::Patrolling, EAction::Unoccupied, Flags::DecisionDue | Flags::InPatrolRadius) == EDecision::EAD_ReachedPatrolTarget, "Patrol arrival");
+	static_assert(Decide(EState::Dead, EAction::Unoccupied, 0xFF) == EDecision::EAD_None, "Corpses never decide");
+	static_assert(PatrolIndexFromCandidate(2, 1) == 3 && PatrolIndexFromCandidate(0, 1) == 0 && PatrolIndexFromCandidate(1, -1) == 1, "The current point is skipped");
+	static_assert(RangeBits(Flags::HasPatrolTarget, 0.f, 0.f, 1.f, 1.f, 1.f) == Flags::InPatrolRadius, "Combat bands need a combat target");
+}
@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "AITypes.h"
+#include "NavigationSystemTypes.h"
+#include "Navigation/PathFollowingComponent.h"
+#include "EnemyNavPathCache.generated.h"
+
+class AAIController;
+class ANavigationData;
+class ARecastNavMesh;
+
+/**
+ * Remembers the navmesh paths enemies asked for, keyed by the nav poly the enemy stood on and the goal actor.
+ * An enemy bouncing between chasing, searching and patrolling asks for the same paths over and over;
+ * while the goal stays put the stored path is handed back instead of running a new navmesh query.
+ * Everything is dropped when the navmesh is rebuilt, poly refs are not stable across rebuilds.
+ */
+UCLASS(Config = Game)
+class RASHEPUR_API UEnemyNavPathCache : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** <UTickableWorldSubsystem> */
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	/** </UTickableWorldSubsystem> */
+
+	/** Same contract as AAIController::MoveTo, with the path coming from the cache when possible */
+	FPathFollowingRequestResult MoveTo(AAIController* Controller, const FAIMoveRequest& MoveRequest, FNavPathSharedPtr* OutPath = nullptr);
+
+	/** AEnemy::MoveTo calls this when it drops a request because the goal has not moved */
+	void RecordSuppressedRepath();
+
+	void Flush();
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	using FPathKey = TPair<NavNodeRef, TObjectKey<AActor>>;
+
+	struct FCachedPath
+	{
+		TArray<FVector> Points;
+		FVector GoalLocation;
+	};
+
+	UFUNCTION()
+	void OnNavigationGenerationFinished(ANavigationData* NavData);
+
+	const ARecastNavMesh* GetNavMesh(const AAIController* Controller) const;
+	FNavPathSharedPtr MakePathFromCache(const FCachedPath& Cached, AAIController* Controller, const ARecastNavMesh* NavMesh, AActor* Goal) const;
+
+	TMap<FPathKey, FCachedPath> Paths;
+
+	/** Pathfinding queries in the current window, published once a second */
+	int32 RepathsInWindow = 0;
+	float RepathWindowTime = 0.f;
+
+	/** How far the goal may have moved from where the stored path ends before it is thrown away */
+	UPROPERTY(Config)
+	float GoalTolerance = 50.f;
+
+	/** The cache is emptied when it grows past this, enemies refill the paths they actually use */
+	UPROPERTY(Config)
+	int32 MaxCachedPaths = 1024;
+};
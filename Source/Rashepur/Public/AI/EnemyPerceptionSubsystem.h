@@ -0,0 +1,94 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "EnemyPerceptionSubsystem.generated.h"
+
+class UPawnSensingComponent;
+class UGameplayTraceScheduler;
+
+/**
+ * Answers "can this enemy see that pawn" from a per pair visibility bit.
+ * The SightRadius and peripheral cone checks run immediately; pairs that pass are collected for the frame
+ * and queued on the UGameplayTraceScheduler, whose async results update the bit the following frame.
+ * A result is reused until the observer or target moves or turns past a tolerance, the sensing settings change
+ * (ExpandSight widening the cone, for example) or it gets older than MaxCacheAge.
+ */
+UCLASS(Config = Game)
+class RASHEPUR_API UEnemyPerceptionSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** <UTickableWorldSubsystem> */
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	/** </UTickableWorldSubsystem> */
+
+	/** Cone and radius test as UPawnSensingComponent::CouldSeePawn, then the cached line of sight bit */
+	bool CanSee(const UPawnSensingComponent* Sensing, const APawn* Target);
+
+	/** Called from OnSeePawn, the sensing component already traced the pair so the result is cached as visible */
+	void NotifySeen(const UPawnSensingComponent* Sensing, const APawn* Target);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	using FSightKey = TPair<TObjectKey<AActor>, TObjectKey<APawn>>;
+
+	struct FSightEntry
+	{
+		FSightKey Key;
+		TWeakObjectPtr<const AActor> Observer;
+		TWeakObjectPtr<const APawn> Target;
+		FVector SensorLocation = FVector::ZeroVector;
+		FRotator SensorRotation = FRotator::ZeroRotator;
+		FVector TargetLocation = FVector::ZeroVector;
+		float PeripheralVisionCosine = 0.f;
+		float SightRadius = 0.f;
+		/** Time the cached result was taken, compared against MaxCacheAge */
+		double CacheTime = 0.0;
+		/** Time of the last CanSee call, entries nobody asks about are dropped */
+		double LastRequestTime = 0.0;
+		bool bInSightCone = false;
+		bool bVisible = true;
+		bool bRequested = false;
+		bool bTraceInFlight = false;
+	};
+
+	static bool PassesSightCone(const UPawnSensingComponent* Sensing, const APawn* Target);
+
+	FSightEntry& FindOrAddEntry(const AActor* Observer, const APawn* Target);
+	bool IsCacheValid(const FSightEntry& Entry, const UPawnSensingComponent* Sensing, const APawn* Target, double Now) const;
+	void Snapshot(FSightEntry& Entry, const UPawnSensingComponent* Sensing, const APawn* Target, double Now) const;
+
+	void SubmitTraces();
+	void PruneEntries();
+	void OnTraceCompleted(const TArray<FHitResult>& Hits, int32 EntryIndex);
+
+	TSparseArray<FSightEntry> Entries;
+	TMap<FSightKey, int32> EntryIndices;
+
+	UPROPERTY()
+	TObjectPtr<UGameplayTraceScheduler> TraceScheduler;
+
+	/** Seconds an entry survives without being asked for */
+	float EntryLifetime = 2.f;
+
+	/** How far either pawn may move before the cached result is thrown away */
+	UPROPERTY(Config)
+	float CacheLocationTolerance = 25.f;
+
+	/** How far the observer may turn, in degrees, before the cached result is thrown away */
+	UPROPERTY(Config)
+	float CacheRotationTolerance = 2.f;
+
+	/** Seconds a result is trusted even when nothing moved, doors and other movers are not tracked */
+	UPROPERTY(Config)
+	float MaxCacheAge = 0.5f;
+};
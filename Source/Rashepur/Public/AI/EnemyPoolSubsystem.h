@@ -0,0 +1,60 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "EnemyPoolSubsystem.generated.h"
+
+class AEnemy;
+
+/** Parked enemies of one class, TMap values cannot be a UPROPERTY TArray directly */
+USTRUCT()
+struct FEnemyPoolBucket
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<TObjectPtr<AEnemy>> Enemies;
+};
+
+/**
+ * Recycles dead and demoted enemies instead of destroying them. A released enemy is hidden, loses collision and leaves
+ * the AI manager, the spatial hash and the proxy subsystem; Acquire hands it back reset to full health with its weapon still attached,
+ * so a kill and respawn cycle does not create or destroy any UObject. Only when a class has no parked enemy is a new one spawned.
+ */
+UCLASS(Config = Game)
+class RASHEPUR_API UEnemyPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** <UWorldSubsystem> */
+	virtual void Deinitialize() override;
+	/** </UWorldSubsystem> */
+
+	/**
+	 * Returns a parked enemy of EnemyClass or spawns a new one at Transform. Prepare runs before the enemy starts its life,
+	 * before BeginPlay for a new actor, so patrol targets and restored state are in place when it registers with the AI.
+	 */
+	AEnemy* Acquire(TSubclassOf<AEnemy> EnemyClass, const FTransform& Transform, TFunctionRef<void(AEnemy&)> Prepare);
+
+	/** Acquire for encounter scripts, the enemy patrols PatrolTargets starting towards PatrolTarget */
+	UFUNCTION(BlueprintCallable, Category = "Enemy Pool")
+	AEnemy* SpawnEnemy(TSubclassOf<AEnemy> EnemyClass, const FTransform& Transform, const TArray<AActor*>& PatrolTargets, AActor* PatrolTarget);
+
+	/** Parks Enemy for a later Acquire, or destroys it once MaxPooledPerClass are already parked */
+	void Release(AEnemy* Enemy);
+
+	int32 GetNumPooled() const;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	UPROPERTY()
+	TMap<TObjectPtr<UClass>, FEnemyPoolBucket> Buckets;
+
+	UPROPERTY(Config)
+	int32 MaxPooledPerClass = 16;
+};
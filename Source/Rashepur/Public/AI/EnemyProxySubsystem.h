@@ -0,0 +1,102 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "MassEntityTypes.h"
+#include "MassEntityQuery.h"
+#include "CharacterStates.h"
+#include "EnemyProxySubsystem.generated.h"
+
+class AEnemy;
+
+/** Everything a demoted enemy needs to come back as it left */
+USTRUCT()
+struct RASHEPUR_API FEnemyProxyFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TSubclassOf<AEnemy> EnemyClass;
+
+	UPROPERTY()
+	FTransform Transform;
+
+	UPROPERTY()
+	float Health = 0.f;
+
+	UPROPERTY()
+	EEnemyState EnemyState = EEnemyState::EES_Patrolling;
+
+	UPROPERTY()
+	TWeakObjectPtr<AActor> PatrolTarget;
+
+	UPROPERTY()
+	TArray<TWeakObjectPtr<AActor>> PatrolTargets;
+
+	/** Route point the enemy last arrived at, see AEnemy::PatrolPointIndex. Proxies do not advance it, a demoted patroller resumes from where it was frozen */
+	UPROPERTY()
+	int32 PatrolPointIndex = INDEX_NONE;
+};
+
+/**
+ * Keeps distant enemies as Mass entities instead of full AEnemy actors. Out of combat enemies farther than DemotionRadius
+ * from the hero and not rendered for DemotionUnrenderedTime are captured into an FEnemyProxyFragment and their actor destroyed;
+ * proxies inside PromotionRadius are spawned back as actors with the captured health, state and patrol progress.
+ * A proxy is frozen: it does not walk its route, so a patroller comes back at the spot and route point it was demoted at.
+ */
+UCLASS(Config = Game)
+class RASHEPUR_API UEnemyProxySubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** <UTickableWorldSubsystem> */
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	/** </UTickableWorldSubsystem> */
+
+	void RegisterEnemy(AEnemy* Enemy);
+	void UnregisterEnemy(AEnemy* Enemy);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	void DemoteDistantEnemies(const FVector& HeroLocation);
+	void PromoteNearbyProxies(const FVector& HeroLocation);
+	void Demote(AEnemy* Enemy);
+	AEnemy* Promote(const FEnemyProxyFragment& Proxy);
+
+	FMassEntityManager* GetEntityManager() const;
+
+	/** Full actors the subsystem may demote */
+	UPROPERTY()
+	TArray<TObjectPtr<AEnemy>> Enemies;
+
+	FMassArchetypeHandle ProxyArchetype;
+	FMassEntityQuery ProxyQuery;
+
+	/** Entities collected during the query, created and destroyed after it */
+	TArray<FMassEntityHandle> PendingPromotions;
+
+	/** Proxies inside this distance of the hero become actors again */
+	UPROPERTY(Config)
+	float PromotionRadius = 8000.f;
+
+	/** Actors beyond this distance become proxies, larger than PromotionRadius so enemies do not flip at the border */
+	UPROPERTY(Config)
+	float DemotionRadius = 10000.f;
+
+	/** An enemy seen within this many seconds stays an actor at any distance, so nothing visible across open ground disappears */
+	UPROPERTY(Config)
+	float DemotionUnrenderedTime = 2.f;
+
+	UPROPERTY(Config)
+	float UpdateInterval = 0.5f;
+
+	float UpdateTimer = 0.f;
+};
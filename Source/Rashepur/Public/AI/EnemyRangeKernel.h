@@ -0,0 +1,44 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Structure of arrays input for the enemy range kernel. Every view has one entry per enemy,
+ * target positions are the enemy's combat target and patrol target, radii are already squared.
+ */
+struct FEnemyRangeKernelInput
+{
+	TConstArrayView<float> EnemyX;
+	TConstArrayView<float> EnemyY;
+	TConstArrayView<float> EnemyZ;
+
+	TConstArrayView<float> TargetX;
+	TConstArrayView<float> TargetY;
+	TConstArrayView<float> TargetZ;
+
+	TConstArrayView<float> PatrolX;
+	TConstArrayView<float> PatrolY;
+	TConstArrayView<float> PatrolZ;
+
+	TConstArrayView<float> CombatRadiusSquared;
+	TConstArrayView<float> AttackRadiusSquared;
+	TConstArrayView<float> PatrolRadiusSquared;
+
+	int32 Num() const { return EnemyX.Num(); }
+};
+
+/**
+ * Computes the CombatRadius, AttackRadius and PatrolRadius bands for every enemy in one pass,
+ * four enemies per SIMD register, using squared distances only.
+ * Band bits (EnemyAIFlags::InCombatRadius, InAttackRadius, InPatrolRadius) are OR'ed into Flags,
+ * combat bits only where HasCombatTarget is set and the patrol bit only where HasPatrolTarget is set.
+ */
+namespace EnemyRangeKernel
+{
+	RASHEPUR_API void ComputeRangeFlags(const FEnemyRangeKernelInput& Input, TArrayView<uint8> Flags);
+
+	/** Reference implementation, also used for the tail that does not fill a register */
+	RASHEPUR_API void ComputeRangeFlagsScalar(const FEnemyRangeKernelInput& Input, TArrayView<uint8> Flags, int32 StartIndex = 0);
+}
@@ -0,0 +1,63 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "NavigationData.h"
+#include "PatrolRouteSubsystem.generated.h"
+
+class AAIController;
+
+/** Navmesh paths between every pair of one patrol point set, baked once and shared by every enemy using that set */
+struct RASHEPUR_API FPatrolRouteGraph
+{
+	TArray<TWeakObjectPtr<AActor>> Points;
+
+	/** Paths of all pairs A < B back to back, the pair's points are PathPoints[PathOffsets[Pair]] up to PathOffsets[Pair + 1] */
+	TArray<FVector> PathPoints;
+	TArray<int32> PathOffsets;
+
+	TWeakObjectPtr<const ANavigationData> NavData;
+
+	int32 Num() const { return Points.Num(); }
+	int32 IndexOf(const AActor* Point) const;
+
+	/** Replaces OutPoints with the baked path From -> To, false when the pair could not be baked */
+	bool GetPath(int32 From, int32 To, TArray<FNavPathPoint>& OutPoints) const;
+
+private:
+	int32 PairIndex(int32 A, int32 B) const;
+
+	friend class UPatrolRouteSubsystem;
+};
+
+/**
+ * Bakes the patrol routes of the level. Enemies register their PatrolTargets at BeginPlay and get back the
+ * route graph for that point set; enemies sharing a set share the graph. Routes are baked again when the navmesh is rebuilt.
+ */
+UCLASS()
+class RASHEPUR_API UPatrolRouteSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** <UWorldSubsystem> */
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+	/** </UWorldSubsystem> */
+
+	/** Route for PatrolTargets on the controller's navmesh, null when there is no valid point */
+	TSharedPtr<const FPatrolRouteGraph> FindOrBakeRoute(const TArray<AActor*>& PatrolTargets, const AAIController* Controller);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	void Bake(FPatrolRouteGraph& Route) const;
+
+	UFUNCTION()
+	void OnNavigationGenerationFinished(ANavigationData* NavData);
+
+	TArray<TSharedPtr<FPatrolRouteGraph>> Routes;
+};
@@ -19,7 +19,9 @@ enum class EActionState : uint8
 	EAS_HitReaction UMETA(DisplayName = "Hit Reaction"),
 	EAS_Occupied UMETA (DisplayName = "Occupied"),
 	EAS_PerformingAction UMETA (DisplayName = "Performing Action"),
-	EAS_Attacking UMETA(DisplayName = "Attacking")
+	EAS_Attacking UMETA(DisplayName = "Attacking"),
+
+	EAS_MAX UMETA(DisplayName = "DefaultMax")
 };
 
 UENUM(BlueprintType)
@@ -42,6 +44,7 @@ enum class EEnemyState: uint8
 	EES_Chasing UMETA(DisplayName = "Chasing"),
 	EES_Searching UMETA(DisplayName = "Searching"),
 	EES_Engaged UMETA(DisplayName = "Engaged"),
-	EES_NoState UMETA(DisplayName = "No State")
+	EES_NoState UMETA(DisplayName = "No State"),
 
+	EES_MAX UMETA(DisplayName = "DefaultMax")
 };
\ No newline at end of file
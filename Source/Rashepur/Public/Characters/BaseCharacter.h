@@ -5,14 +5,33 @@
 #include "CoreMinimal.h"
 #include "Interfaces/HitInterface.h"
 #include "CharacterStates.h"
+#include "Rashepur/Weapons/WeaponTypes.h"
 #include "GameFramework/Character.h"
 #include "BaseCharacter.generated.h"
 
 class AWeapon;
 class UAnimMontage;
+class UAnimInstance;
 class UAttributeComponent;
+class UCombatStatusComponent;
+struct FMontageSectionRef;
+enum class EMontageSection : uint8;
 class UPawnSensingComponent;
 
+/** What the anim instances read, copied on the game thread once per frame so their update can run on a worker thread */
+struct FCharacterAnimSnapshot
+{
+	float GroundSpeed = 0.f;
+	bool bIsFalling = false;
+	ECharacterState CharacterState = ECharacterState::ECS_Unequipped;
+	EEnemyState EnemyState = EEnemyState::EES_NoState;
+};
+
+namespace CharacterAnim
+{
+	/** Warns once per anim blueprint whose update cannot leave the game thread, the snapshot split buys nothing there. Development builds only */
+	RASHEPUR_API void WarnIfGameThreadOnly(const UAnimInstance* AnimInstance);
+}
 
 
 UCLASS()
@@ -24,16 +43,25 @@ public:
 	ABaseCharacter();
 	virtual void Tick(float DeltaTime) override;
 
+	FORCEINLINE const UCombatStatusComponent* GetCombatStatus() const { return CombatStatus; }
+
+	/** Called by the anim instance before its update, the only game thread work the update still needs */
+	virtual void PublishAnimSnapshot(FCharacterAnimSnapshot& OutSnapshot) const;
+
 protected:
 	virtual void BeginPlay() override;
 
 
 	UFUNCTION(BlueprintCallable)
-	void SetWeaponCollisionEnabled(ECollisionEnabled::Type CollisionEnabled);
+	virtual void SetWeaponCollisionEnabled(ECollisionEnabled::Type CollisionEnabled);
+
+	/** Type of the weapon in hand, unset when unarmed. Enemies hold theirs in a UWeaponLoadoutComponent instead of EquippedWeapon */
+	virtual TOptional<EWeaponType> GetHeldWeaponType() const;
 
 	virtual	void MoveTo(AActor* Target, bool DrawDebugSpheresOnPath = false);
 
 	FName GetWeaponSocket(AWeapon* Weapon);
+	FName GetWeaponSocket(EWeaponType WeaponType) const;
 
 	/**
 	 *	Animation Montages
@@ -52,13 +80,21 @@ protected:
 
 	void PlaySearchMontage();
 	float GetSearchMontageLength();
-	UAnimInstance* PlayHitReactMontage(const FName& SectionName);
-	UAnimInstance* PlayMontageSection(UAnimMontage* Montage, const FName& SectionName, float AnimationSpeed = 1.0f, bool SetEndDelegate = true);
+	UAnimInstance* PlayHitReactMontage(EMontageSection Section);
+	/** Starts Montage at Section instead of playing it and jumping, see UMontageSectionRegistry */
+	UAnimInstance* PlayMontageSection(UAnimMontage* Montage, const FMontageSectionRef& Section, float AnimationSpeed = 1.0f, bool SetEndDelegate = true);
 	void StopAnimMontage(UAnimMontage* Montage);
-	FName RandomMontageSection(UAnimMontage* Montage, FString MontagePrefix);
+	FMontageSectionRef GetMontageSection(const UAnimMontage* Montage, EMontageSection Section) const;
+	/** One of the "AttackN" sections, picked at random */
+	FMontageSectionRef RandomAttackSection(const UAnimMontage* Montage) const;
+	/** Resolves the section tables of every montage this character plays */
+	virtual void RegisterMontageSections();
 
 	virtual void OnActionEnded(UAnimMontage* Montage, bool bInterrupted); // callback to end montage
 
+	/** Checks the change against CharacterStateTransitions and counts it in development builds */
+	void SetActionState(EActionState NewState);
+
 	/** 
 	 *	Combat
 	 */
@@ -71,6 +107,8 @@ protected:
 	virtual bool CanAttack();
 	virtual void HandleDamage(float DamageAmount);
 	virtual void Die();
+	/** Runs at the end of Die, the default lets the body disappear after DeathLifeSpan */
+	virtual void ScheduleDeathCleanup();
 	bool IsAlive();
 	virtual bool IsUnocuppied();
 	void DisableCapsule();	
@@ -109,6 +147,9 @@ protected:
 	UPROPERTY(EditDefaultsOnly)
 	UAttributeComponent* CharAttributes;
 
+	UPROPERTY(VisibleAnywhere)
+	UCombatStatusComponent* CombatStatus;
+
 	UPROPERTY(BlueprintReadOnly, meta = (AllowPrivateAccess = "true"), Category = "Weapon")
 	AWeapon* EquippedWeapon;
 
@@ -127,6 +168,8 @@ protected:
 	const float DefaultPeripheralVision = 85.f;
 
 private:
+	friend class UAnimNotifyState_WeaponCollision;
+	friend class UBakeWeaponSwingTracksCommandlet;
 
 	/** Animation Montages */
 	UPROPERTY(EditDefaultsOnly, Category = "Montages")
@@ -0,0 +1,126 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CharacterStates.h"
+
+/** State change logging, gated by the character's bDebugStates and compiled out of Shipping builds */
+#if UE_BUILD_SHIPPING
+#define RASHEPUR_STATE_LOG(bEnabled, Verbosity, Format, ...) do { } while (0)
+#else
+#define RASHEPUR_STATE_LOG(bEnabled, Verbosity, Format, ...) do { if (bEnabled) { UE_LOG(LogTemp, Verbosity, Format, ##__VA_ARGS__); } } while (0)
+#endif
+
+#define RASHEPUR_WITH_STATE_STATS !UE_BUILD_SHIPPING
+
+/**
+ * Legal EEnemyState and EActionState changes as flat constexpr tables, one bit mask per state being left.
+ * The tables are checked with static_asserts below; at runtime a transition costs one indexed bit test.
+ */
+namespace CharacterStateTransitions
+{
+	constexpr int32 NumEnemyStates = (int32)EEnemyState::EES_MAX;
+	constexpr int32 NumActionStates = (int32)EActionState::EAS_MAX;
+
+	static_assert(NumEnemyStates <= 32 && NumActionStates <= 32, "Transition rows are uint32 masks");
+
+	constexpr uint32 Bit(EEnemyState State) { return 1u << (uint32)State; }
+	constexpr uint32 Bit(EActionState State) { return 1u << (uint32)State; }
+
+	constexpr uint32 AnyAliveEnemyState =
+		Bit(EEnemyState::EES_Staggered) | Bit(EEnemyState::EES_Patrolling) | Bit(EEnemyState::EES_Chasing) |
+		Bit(EEnemyState::EES_Searching) | Bit(EEnemyState::EES_Engaged) | Bit(EEnemyState::EES_NoState);
+
+	/** Every living state can be hit (Staggered), killed, or cleared back to NoState */
+	constexpr uint32 AlwaysEnemyStates = Bit(EEnemyState::EES_Staggered) | Bit(EEnemyState::EES_Dead) | Bit(EEnemyState::EES_NoState);
+
+	/** Indexed by the state being left, in EEnemyState order */
+	constexpr uint32 EnemyStateEdges[NumEnemyStates] =
+	{
+		/* Staggered */ AlwaysEnemyStates | Bit(EEnemyState::EES_Chasing),
+		/* Dead */ Bit(EEnemyState::EES_Dead),
+		/* Patrolling */ AlwaysEnemyStates | Bit(EEnemyState::EES_Patrolling) | Bit(EEnemyState::EES_Chasing),
+		/* Chasing */ AlwaysEnemyStates | Bit(EEnemyState::EES_Chasing) | Bit(EEnemyState::EES_Searching) | Bit(EEnemyState::EES_Engaged),
+		/* Searching */ AlwaysEnemyStates | Bit(EEnemyState::EES_Searching) | Bit(EEnemyState::EES_Patrolling) | Bit(EEnemyState::EES_Chasing),
+		/* Engaged */ AlwaysEnemyStates | Bit(EEnemyState::EES_Engaged) | Bit(EEnemyState::EES_Searching),
+		/* NoState */ AlwaysEnemyStates | AnyAliveEnemyState,
+	};
+
+	/** Indexed by the action being left, in EActionState order */
+	constexpr uint32 AnyActionState = (1u << NumActionStates) - 1;
+	constexpr uint32 ActionStateEdges[NumActionStates] =
+	{
+		/* Unoccupied */ AnyActionState,
+		/* HitReaction */ AnyActionState,
+		/* Occupied */ Bit(EActionState::EAS_Unoccupied) | Bit(EActionState::EAS_Occupied),
+		/* PerformingAction */ AnyActionState,
+		/* Attacking */ Bit(EActionState::EAS_Unoccupied) | Bit(EActionState::EAS_Attacking) | Bit(EActionState::EAS_Occupied),
+	};
+
+	constexpr bool IsLegal(EEnemyState From, EEnemyState To) { return (EnemyStateEdges[(int32)From] & Bit(To)) != 0; }
+	constexpr bool IsLegal(EActionState From, EActionState To) { return (ActionStateEdges[(int32)From] & Bit(To)) != 0; }
+
+	/** Whether the AI manager has to run decisions for an enemy in this state, the rest wait on events */
+	constexpr bool EnemyStateNeedsDecisions[NumEnemyStates] =
+	{
+		/* Staggered */ false,
+		/* Dead */ false,
+		/* Patrolling */ false,
+		/* Chasing */ true,
+		/* Searching */ true,
+		/* Engaged */ true,
+		/* NoState */ true,
+	};
+
+	/** For call sites whose previous states are fixed: every state in From may change to To */
+	template<EEnemyState To, EEnemyState... From>
+	constexpr bool AreLegal() { return (IsLegal(From, To) && ...); }
+
+	template<EEnemyState... States>
+	constexpr uint32 Bits() { return (Bit(States) | ... | 0u); }
+
+	constexpr bool IsTerminal(EEnemyState State) { return EnemyStateEdges[(int32)State] == Bit(State); }
+
+	constexpr bool HasSelfEdges()
+	{
+		for (int32 State = 0; State < NumEnemyStates; ++State)
+			if (!(EnemyStateEdges[State] & (1u << State)))
+				return false;
+		return true;
+	}
+
+	constexpr bool EveryLivingStateCanDie()
+	{
+		for (int32 State = 0; State < NumEnemyStates; ++State)
+			if (!(EnemyStateEdges[State] & Bit(EEnemyState::EES_Dead)))
+				return false;
+		return true;
+	}
+
+	constexpr bool EveryStateReachableFromNoState()
+	{
+		uint32 Reached = Bit(EEnemyState::EES_NoState);
+		for (int32 Step = 0; Step < NumEnemyStates; ++Step)
+			for (int32 State = 0; State < NumEnemyStates; ++State)
+				if (Reached & (1u << State))
+					Reached |= EnemyStateEdges[State];
+		return Reached == (1u << NumEnemyStates) - 1;
+	}
+
+	static_assert(sizeof(EnemyStateEdges) / sizeof(EnemyStateEdges[0]) == NumEnemyStates, "EnemyStateEdges needs a row per EEnemyState");
+	static_assert(sizeof(ActionStateEdges) / sizeof(ActionStateEdges[0]) == NumActionStates, "ActionStateEdges needs a row per EActionState");
+	static_assert(HasSelfEdges(), "Re-entering the current state is always allowed");
+	static_assert(IsTerminal(EEnemyState::EES_Dead), "Nothing leaves EES_Dead");
+	static_assert(EveryLivingStateCanDie(), "Any state can be killed");
+	static_assert(EveryStateReachableFromNoState(), "Every enemy state must be reachable from EES_NoState");
+	static_assert(!EnemyStateNeedsDecisions[(int32)EEnemyState::EES_Dead], "Corpses never decide");
+	static_assert(IsLegal(EEnemyState::EES_Searching, EEnemyState::EES_Patrolling), "SearchTimerFinished goes back to patrolling");
+	static_assert(!IsLegal(EEnemyState::EES_Engaged, EEnemyState::EES_Chasing), "Engaged enemies only chase again after NoState");
+
+#if RASHEPUR_WITH_STATE_STATS
+	/** Per edge counters, row is the state left, column the state entered */
+	RASHEPUR_API void RecordTransition(EEnemyState From, EEnemyState To);
+	RASHEPUR_API void RecordTransition(EActionState From, EActionState To);
+#endif
+}
@@ -0,0 +1,95 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "MontageSectionRegistry.generated.h"
+
+class UAnimMontage;
+
+/** The sections characters play by name, resolved to indices once per montage */
+enum class EMontageSection : uint8
+{
+	FromFront,
+	FromBack,
+	FromLeft,
+	FromRight,
+	LookAround,
+	Equip,
+	Unequip,
+
+	MAX
+};
+
+/** A section of one montage, Index is INDEX_NONE when the montage does not have it and playback starts at the beginning */
+struct FMontageSectionRef
+{
+	int32 Index = INDEX_NONE;
+	float StartTime = 0.f;
+};
+
+struct FMontageSectionTable
+{
+	FMontageSectionRef Named[(int32)EMontageSection::MAX];
+	/** "Attack1" to "AttackN", the random attack variants */
+	TArray<FMontageSectionRef> Attacks;
+	int32 NumSections = 0;
+
+	FORCEINLINE const FMontageSectionRef& Get(EMontageSection Section) const { return Named[(int32)Section]; }
+};
+
+/**
+ * Resolves montage sections to index tables the first time a montage is registered, so picking and starting a section
+ * does no FString or FName work afterwards. Montages are shared between every character using them, hence one table per
+ * montage rather than per character. Tables live as long as the world, so every PIE session resolves fresh data,
+ * and a montage edited while playing in the editor is resolved again on its next use.
+ */
+UCLASS()
+class RASHEPUR_API UMontageSectionRegistry : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** <UWorldSubsystem> */
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	/** </UWorldSubsystem> */
+
+	/** Resolves Montage if it is new, characters register theirs in BeginPlay */
+	void Register(const UAnimMontage* Montage);
+
+	/** Hot path lookups, a pointer hash; returned by value since registering another montage may move the tables */
+	FORCEINLINE FMontageSectionRef GetSection(const UAnimMontage* Montage, EMontageSection Section)
+	{
+		return FindOrResolve(Montage).Get(Section);
+	}
+
+	/** One of the "AttackN" sections picked at random, the montage start when there are none */
+	FMontageSectionRef RandomAttack(const UAnimMontage* Montage);
+
+	/** Null for worlds that never play montages (editor, preview) */
+	static UMontageSectionRegistry* Find(const UWorld* World);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	/** Montages nobody registered are resolved on the spot */
+	FORCEINLINE const FMontageSectionTable& FindOrResolve(const UAnimMontage* Montage)
+	{
+		if (const FMontageSectionTable* Table = Tables.Find(Montage))
+			return *Table;
+		return Tables.Add(Montage, Resolve(Montage));
+	}
+
+	static FMontageSectionTable Resolve(const UAnimMontage* Montage);
+
+#if WITH_EDITOR
+	void OnObjectPropertyChanged(UObject* Object, FPropertyChangedEvent& PropertyChangedEvent);
+	FDelegateHandle ObjectPropertyChangedHandle;
+#endif
+
+	TMap<TObjectKey<UAnimMontage>, FMontageSectionTable> Tables;
+};
@@ -0,0 +1,42 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "BakeWeaponSwingTracksCommandlet.generated.h"
+
+class ABaseCharacter;
+class UAnimMontage;
+class USkeletalMesh;
+class UWeaponSwingTrack;
+
+/**
+ * Bakes a UWeaponSwingTrack next to each attack montage of a character Blueprint:
+ *   UnrealEditor-Cmd Rashepur.uproject -run=BakeWeaponSwingTracks -Character=/Game/Blueprints/Enemy/BP_Enemy [-SampleRate=60]
+ *     [-Sockets=OneHandedSocket,TwoHandedSocket,DualHandSocket] [-EnableNotify=Name -DisableNotify=Name]
+ * The active window of an "AttackN" section is its Weapon Collision Window notify state, or the span between the named
+ * enable and disable notifies for montages still toggling collision from the anim Blueprint.
+ */
+UCLASS()
+class RASHEPUR_API UBakeWeaponSwingTracksCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UBakeWeaponSwingTracksCommandlet();
+	virtual int32 Main(const FString& Params) override;
+
+private:
+#if WITH_EDITOR
+	bool BakeMontage(UAnimMontage* Montage, USkeletalMesh* Mesh, const FTransform& MeshToActor, UWeaponSwingTrack& Track) const;
+	bool FindActiveWindow(const UAnimMontage* Montage, float SectionStart, float SectionEnd, float& OutStart, float& OutEnd) const;
+	bool SampleSocket(const UAnimMontage* Montage, USkeletalMesh* Mesh, FName Socket, float MontageTime, FTransform& OutComponentSpace) const;
+	bool SaveTrack(UWeaponSwingTrack* Track) const;
+#endif
+
+	TArray<FName> Sockets;
+	FName EnableNotify;
+	FName DisableNotify;
+	float SampleRate = 60.f;
+};
@@ -0,0 +1,60 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Engine/HitResult.h"
+#include "DamageResolutionSubsystem.generated.h"
+
+class AController;
+
+/** Runs once per victim after the hit was applied, weapons spawn their fields from it */
+DECLARE_DELEGATE_OneParam(FOnHitResolved, const FHitResult& /*Hit*/);
+
+/**
+ * Collects weapon hits during the frame and resolves them together. Hits from the same attacker on the same victim during
+ * one swing are merged, keeping the strongest. Every merged hit applies its damage, then each victim gets a single GetHit
+ * reaction and effect, so a dual wield or cleave swing cannot replay sounds, particles and montages on one target.
+ */
+UCLASS()
+class RASHEPUR_API UDamageResolutionSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** <UTickableWorldSubsystem> */
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	/** </UTickableWorldSubsystem> */
+
+	/** SwingId tells separate swings of the same Hitter apart, hits sharing all three are one hit */
+	void QueueHit(const FHitResult& Hit, float Damage, AController* EventInstigator, AActor* DamageCauser, AActor* Hitter, uint32 SwingId, FOnHitResolved OnResolved);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FQueuedHit
+	{
+		FHitResult Hit;
+		TWeakObjectPtr<AActor> Victim;
+		TWeakObjectPtr<AActor> Hitter;
+		TWeakObjectPtr<AActor> DamageCauser;
+		TWeakObjectPtr<AController> EventInstigator;
+		FOnHitResolved OnResolved;
+		float Damage = 0.f;
+	};
+
+	/** Hitter, victim, swing */
+	using FHitKey = TTuple<TObjectKey<AActor>, TObjectKey<AActor>, uint32>;
+
+	void ResolveHits();
+	void ResolveVictim(TArrayView<FQueuedHit> VictimHits);
+
+	TArray<FQueuedHit> QueuedHits;
+	TMap<FHitKey, int32> QueuedHitIndices;
+	/** Swapped with QueuedHits while resolving, hits queued by a reaction wait for the next frame */
+	TArray<FQueuedHit> ResolvingHits;
+};
@@ -0,0 +1,63 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "WeaponSwingTrack.generated.h"
+
+class UAnimMontage;
+
+/** Path of one weapon socket through one montage section, sampled only inside the active damage window */
+USTRUCT()
+struct RASHEPUR_API FWeaponSwingSection
+{
+	GENERATED_BODY()
+
+	UPROPERTY(VisibleAnywhere, Category = "Swing")
+	FName Section;
+
+	UPROPERTY(VisibleAnywhere, Category = "Swing")
+	FName Socket;
+
+	/** Active damage window in seconds from the start of the section */
+	UPROPERTY(VisibleAnywhere, Category = "Swing")
+	float ActiveStart = 0.f;
+
+	UPROPERTY(VisibleAnywhere, Category = "Swing")
+	float ActiveEnd = 0.f;
+
+	UPROPERTY(VisibleAnywhere, Category = "Swing")
+	float SampleInterval = 1.f / 60.f;
+
+	/** Socket transform in actor space, one sample every SampleInterval starting at ActiveStart */
+	UPROPERTY()
+	TArray<FVector3f> Locations;
+
+	UPROPERTY()
+	TArray<FQuat4f> Rotations;
+
+	FORCEINLINE bool IsActive(float SectionTime) const { return SectionTime >= ActiveStart && SectionTime <= ActiveEnd && Locations.Num() > 0; }
+
+	/** Socket in actor space at SectionTime, clamped to the window */
+	FTransform Sample(float SectionTime) const;
+};
+
+/**
+ * Weapon socket paths baked offline from an attack montage by the BakeWeaponSwingTracks commandlet, so hit detection can build
+ * its sweeps from the track and the actor transform instead of an evaluated pose.
+ */
+UCLASS()
+class RASHEPUR_API UWeaponSwingTrack : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	const FWeaponSwingSection* FindSection(FName Section, FName Socket) const;
+
+	UPROPERTY(VisibleAnywhere, Category = "Swing")
+	TObjectPtr<UAnimMontage> Montage;
+
+	UPROPERTY(VisibleAnywhere, Category = "Swing")
+	TArray<FWeaponSwingSection> Sections;
+};
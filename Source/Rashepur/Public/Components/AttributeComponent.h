@@ -31,4 +31,7 @@ public:
 	void ReceiveDamage(float Damage);
 	float GetHealthPercent();
 	bool isAlive();
+	void SetHealth(float NewHealth);
+	FORCEINLINE float GetHealth() const { return Health; }
+	FORCEINLINE float GetMaxHealth() const { return MaxHealth; }
 };
@@ -0,0 +1,107 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "CombatStatusComponent.generated.h"
+
+UENUM(BlueprintType)
+enum class ECombatFaction : uint8
+{
+	ECF_Neutral UMETA(DisplayName = "Neutral"),
+	ECF_Hero UMETA(DisplayName = "Hero"),
+	ECF_Enemy UMETA(DisplayName = "Enemy"),
+
+	ECF_MAX UMETA(DisplayName = "DefaultMax")
+};
+
+UENUM(BlueprintType, meta = (Bitflags, UseEnumValuesAsMaskValuesInEditor = "true"))
+enum class ECombatStatus : uint8
+{
+	ECST_None = 0 UMETA(Hidden),
+	ECST_Dead = 1 << 0 UMETA(DisplayName = "Dead"),
+	ECST_Invulnerable = 1 << 1 UMETA(DisplayName = "Invulnerable"),
+	ECST_Staggered = 1 << 2 UMETA(DisplayName = "Staggered")
+};
+ENUM_CLASS_FLAGS(ECombatStatus);
+
+UENUM(BlueprintType)
+enum class ECombatAttitude : uint8
+{
+	ECA_Friendly UMETA(DisplayName = "Friendly"),
+	ECA_Neutral UMETA(DisplayName = "Neutral"),
+	ECA_Hostile UMETA(DisplayName = "Hostile")
+};
+
+/**
+ * Who attacks whom as constexpr bit masks, one row per faction with a bit for every faction it is friendly or hostile to.
+ * Factions in neither mask are neutral, so anyone can still smash the breakables, which have no faction at all.
+ */
+namespace CombatAttitude
+{
+	constexpr int32 NumFactions = (int32)ECombatFaction::ECF_MAX;
+	static_assert(NumFactions <= 8, "Attitude rows are uint8 masks");
+
+	constexpr uint8 Bit(ECombatFaction Faction) { return (uint8)(1u << (uint8)Faction); }
+
+	/** Indexed by the faction looking, in ECombatFaction order */
+	constexpr uint8 Friendly[NumFactions] =
+	{
+		/* Neutral */ 0,
+		/* Hero */ Bit(ECombatFaction::ECF_Hero),
+		/* Enemy */ Bit(ECombatFaction::ECF_Enemy),
+	};
+
+	constexpr uint8 Hostile[NumFactions] =
+	{
+		/* Neutral */ 0,
+		/* Hero */ Bit(ECombatFaction::ECF_Enemy),
+		/* Enemy */ Bit(ECombatFaction::ECF_Hero),
+	};
+
+	constexpr ECombatAttitude Get(ECombatFaction From, ECombatFaction To)
+	{
+		return (Friendly[(int32)From] & Bit(To)) ? ECombatAttitude::ECA_Friendly
+			: (Hostile[(int32)From] & Bit(To)) ? ECombatAttitude::ECA_Hostile
+			: ECombatAttitude::ECA_Neutral;
+	}
+
+	static_assert(Get(ECombatFaction::ECF_Enemy, ECombatFaction::ECF_Enemy) == ECombatAttitude::ECA_Friendly, "Enemies do not hurt each other");
+	static_assert(Get(ECombatFaction::ECF_Hero, ECombatFaction::ECF_Enemy) == ECombatAttitude::ECA_Hostile, "The hero fights enemies");
+	static_assert(Get(ECombatFaction::ECF_Enemy, ECombatFaction::ECF_Hero) == ECombatAttitude::ECA_Hostile, "Enemies fight the hero");
+}
+
+/**
+ * Faction and combat status of an actor as a byte each, so friend, foe and dead checks in the combat hot paths are bit tests
+ * instead of scans of the Tags array. Actors without one are neutral and never dead.
+ */
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class RASHEPUR_API UCombatStatusComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:	
+	UCombatStatusComponent();
+
+	/** Characters keep theirs in a member, any other actor costs a component search */
+	static const UCombatStatusComponent* Find(const AActor* Actor);
+
+	static ECombatFaction GetFaction(const AActor* Actor);
+	static bool HasStatus(const AActor* Actor, ECombatStatus Status);
+	static ECombatAttitude GetAttitude(const AActor* From, const AActor* To);
+	/** Whether From's weapons may hurt To: not a friend and not invulnerable */
+	static bool CanDamage(const AActor* From, const AActor* To);
+
+	FORCEINLINE ECombatFaction GetFaction() const { return Faction; }
+	FORCEINLINE bool HasStatus(ECombatStatus InStatus) const { return EnumHasAnyFlags(Status, InStatus); }
+	void SetStatus(ECombatStatus InStatus, bool bSet);
+	void SetFaction(ECombatFaction NewFaction);
+
+private:
+	UPROPERTY(EditAnywhere, Category = "Combat")
+	ECombatFaction Faction = ECombatFaction::ECF_Neutral;
+
+	UPROPERTY(VisibleInstanceOnly, Category = "Combat", meta = (Bitmask, BitmaskEnum = "/Script/Rashepur.ECombatStatus"))
+	ECombatStatus Status = ECombatStatus::ECST_None;
+};
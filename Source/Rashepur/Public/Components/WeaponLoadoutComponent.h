@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "Rashepur/Weapons/WeaponTypes.h"
+#include "Rashepur/Weapons/WeaponHitbox.h"
+#include "WeaponLoadoutComponent.generated.h"
+
+class AWeapon;
+class UBoxComponent;
+class UWeaponSwingTrack;
+struct FWeaponSwingSection;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnLoadoutWeaponHit, const FVector&, ImpactPoint);
+
+/** One weapon in hand, a mesh and its hit box attached to the character */
+USTRUCT()
+struct FHeldWeapon
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TObjectPtr<UStaticMeshComponent> Mesh;
+
+	UPROPERTY()
+	TObjectPtr<UBoxComponent> Box;
+
+	UPROPERTY()
+	FName Socket;
+
+	/** BoxTraceStart and BoxTraceEnd of the weapon class, relative to Box */
+	FTransform TraceStart;
+	FVector TraceEnd = FVector::ZeroVector;
+
+	FWeaponSwing Swing;
+};
+
+/**
+ * Weapons a character holds but never drops, built as plain mesh and box components from an AWeapon class's defaults.
+ * The hover tick, embers and pickup sphere of an AWeapon actor are skipped, those only matter for weapons lying in the world.
+ * EWT_BothHands gets a weapon in each hand, and every held weapon's collision is toggled together.
+ */
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class RASHEPUR_API UWeaponLoadoutComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UWeaponLoadoutComponent();
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/** Replaces the held weapons with WeaponClass in MainSocket, and a second one in OffHandSocket for EWT_BothHands */
+	void Equip(TSubclassOf<AWeapon> WeaponClass, USceneComponent* Parent, FName MainSocket, FName OffHandSocket);
+	void Unequip();
+
+	/** Same contract as AWeapon::EnableWeaponCollision / DisableWeaponCollision, and a new swing can hit everyone again */
+	void SetWeaponCollisionEnabled(ECollisionEnabled::Type CollisionEnabled);
+
+	TOptional<EWeaponType> GetWeaponType() const;
+
+	/** Baked attack paths, while one of their montages plays the blades come from the track and only sweep inside its active window */
+	UPROPERTY(EditDefaultsOnly, Category = "Weapon")
+	TArray<TObjectPtr<UWeaponSwingTrack>> SwingTracks;
+
+	/** Stands in for AWeapon::CreateFields, which lives on the weapon Blueprint */
+	UPROPERTY(BlueprintAssignable)
+	FOnLoadoutWeaponHit OnWeaponHit;
+
+protected:
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	UFUNCTION()
+	void OnBoxOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
+
+	void AddHeldWeapon(const AWeapon* WeaponDefaults, USceneComponent* Parent, FName Socket);
+	void SetBoxCollisionEnabled(const FHeldWeapon& Held, bool bEnabled) const;
+	void GetBlade(const FHeldWeapon& Held, FTransform& OutBladeStart, FVector& OutBladeEnd) const;
+	const FWeaponSwingSection* FindBakedSwing(FName Socket, float& OutSectionTime) const;
+	void TickSwings();
+	void DeliverHit(const FHitResult& Hit);
+	void OnHitResolved(const FHitResult& Hit);
+
+	UPROPERTY()
+	TArray<FHeldWeapon> HeldWeapons;
+
+	/** Shared by both hands, a dual wield swing hits each actor once */
+	UPROPERTY()
+	TArray<AActor*> IgnoreActors;
+	TSet<TObjectKey<AActor>> SwingHitActors;
+	TArray<FHitResult> SwingHits;
+	uint32 SwingId = 0;
+
+	EWeaponType WeaponType = EWeaponType::EWT_OneHand;
+	FVector TraceExtent = FVector(8.f);
+	float Damage = 0.f;
+	bool bShowTraceDebug = false;
+	bool bUseSwingTracking = true;
+};
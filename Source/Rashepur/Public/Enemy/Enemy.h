@@ -5,10 +5,17 @@
 #include "CoreMinimal.h"
 #include "CharacterStates.h"
 #include "Characters/BaseCharacter.h"
+#include "AI/EnemyAITypes.h"
+#include "AI/EnemyAnimSharingSubsystem.h"
+#include "AI/Navigation/NavigationTypes.h"
+#include "Navigation/PathFollowingComponent.h"
 #include "Enemy.generated.h"
 
 
 class UHealthBarComponent;
+class UWeaponLoadoutComponent;
+struct FPatrolRouteGraph;
+struct FEnemyProxyFragment;
 
 
 UCLASS()
@@ -20,29 +27,49 @@ public:
 	AEnemy();
 
 	/** <AActor> */
-	virtual void Tick(float DeltaTime) override;
 	virtual float TakeDamage(float DamageAmount, struct FDamageEvent const& DamageEvent, class AController* EventInstigator, AActor* DamageCauser) override;
-	virtual void Destroyed() override;
 	/** </AActor> */
 
+	/** <ACharacter> */
+	virtual void OnMovementModeChanged(EMovementMode PrevMovementMode, uint8 PreviousCustomMode = 0) override;
+	/** </ACharacter> */
+
 	/** <IHitInterface> */
 	virtual void GetHit_Implementation(const FVector& ImpactPoint, AActor* Hitter) override;
 
 	/** </IHitInterface> */
 
+	/** Round trip through UEnemyProxySubsystem, Restore runs on a deferred spawn before BeginPlay */
+	bool CanBeDemoted();
+	void CaptureProxyState(FEnemyProxyFragment& Proxy) const;
+	void RestoreProxyState(const FEnemyProxyFragment& Proxy);
+
+	/** Pool lifecycle driven by UEnemyPoolSubsystem: Park, then Reset, whatever the caller prepares, then Activate */
+	void ParkInPool();
+	void ResetFromPool(const FTransform& Transform);
+	void ActivateEnemy();
+	void SetPatrolTargets(const TArray<AActor*>& NewPatrolTargets, AActor* NewPatrolTarget);
+
+	/** <ABaseCharacter> */
+	virtual void PublishAnimSnapshot(FCharacterAnimSnapshot& OutSnapshot) const override;
+	/** </ABaseCharacter> */
 
 protected:
 	/** <ABaseCharacter> */
 	virtual void OnActionEnded(UAnimMontage* Montage, bool bInterrupted) override;
 	void ClearStates();
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	virtual void Die() override;
+	virtual void ScheduleDeathCleanup() override;
 	virtual void Attack() override;
 	virtual bool CanAttack() override;
 
 	virtual void PlayAttackMontage() override;
 	virtual void HandleDamage(float DamageAmount) override;
 	virtual void MoveTo(AActor* Target, bool DrawDebugSpheresOnPath = false) override;
+	virtual void SetWeaponCollisionEnabled(ECollisionEnabled::Type CollisionEnabled) override;
+	virtual TOptional<EWeaponType> GetHeldWeaponType() const override;
 
 	/** </ABaseCharacter> */
 
@@ -62,7 +89,15 @@ protected:
 	float MoveAcceptanceRadius = 20.f;
 
 private:
+	friend class UEnemyAIManager;
+	friend class UEnemyAnimSharingSubsystem;
+	friend struct FEnemyPoolSoak;
+	friend struct FEnemyDormancySoak;
+
 	void InitializeEnemy();
+	void RegisterWithSubsystems();
+	void UnregisterFromSubsystems();
+	void ReleaseToPool();
 
 	/** AI Navigation and control */
 	void Stagger();
@@ -73,16 +108,39 @@ private:
 
 	void TurnToPlayer(UAnimMontage* Montage, bool bInterrupted);
 
-	void CheckCombatTarget();
-	bool CanEngage();
-	bool CanSearch();
-	bool CanChase();
-	void CheckPatrolTarget();
-	
-	bool IsOutsideCombatRadius() const;
-	bool IsOutsideAttackRadius() const;
-		
-	bool IsInsideAttackRadius() const;
+	/** Called by UEnemyAIManager with this frame's decision */
+	void ApplyAIDecision(EEnemyAIDecision Decision, bool bInCombatRadius, float DeltaTime);
+	void ApplyCombatDecision(EEnemyAIDecision Decision);
+	void ReachedPatrolTarget();
+	void ApplyAILODTier(const FEnemyAILODTier& Tier);
+	/** Anim graph evaluated every TickRate frames, update rate optimisation interpolates the frames in between */
+	void SetAnimTickRate(uint8 TickRate);
+	/** PawnSensing only runs while the hero could be within SightRadius, set from the AI manager's spatial hash query */
+	void SetSensingInRange(bool bInRange);
+
+	/** Every state change goes through here so the AI manager and movement know whether the enemy is idle */
+	void SetEnemyState(EEnemyState NewState);
+	/** SetEnemyState for call sites that can only be in one of From, the edges are checked at compile time instead of per call */
+	template<EEnemyState To, EEnemyState... From>
+	void TransitionEnemyState();
+	/** Runs the entry handler of the new state, then updates the AI activity */
+	void EnterEnemyState(EEnemyState NewState);
+	void EnterStaggered();
+	void EnterPatrolling();
+	void EnterChasing();
+	/** Every state without its own setup, only drops the Staggered status */
+	void EnterUnstaggered();
+
+	using FEnemyStateHandler = void (AEnemy::*)();
+	/** Indexed by EEnemyState */
+	static const FEnemyStateHandler EnemyStateEnterHandlers[(int32)EEnemyState::EES_MAX];
+	void UpdateAIActivity();
+	/** Joins or leaves the leader pose group of the current state, see UEnemyAnimSharingSubsystem */
+	void UpdateAnimSharing();
+	bool NeedsAIDecisions() const;
+
+	UFUNCTION()
+	void OnMoveCompleted(FAIRequestID RequestID, EPathFollowingResult::Type Result);
 
 	bool IsAttacking() const;
 	bool IsPatrolling() const;
@@ -116,8 +174,8 @@ private:
 	void StopAllActions();
 
 	AActor* ChoosePatrolTarget();
-
-	bool InTargetRange(AActor* Target, double Radius) const;
+	bool FollowPatrolRoute();
+	bool IsAlreadyMovingTo(AActor* Target) const;
 
 	FOnMontageEnded HitReactEndedDelegate;
 
@@ -128,6 +186,9 @@ private:
 	UPROPERTY(VisibleAnywhere)
 	UHealthBarComponent* HealthBarWidget;
 
+	UPROPERTY(VisibleAnywhere)
+	UWeaponLoadoutComponent* WeaponLoadout;
+
 	UPROPERTY(EditAnywhere)
 	TSubclassOf<class AWeapon> DefaultWeaponClass;
 
@@ -142,6 +203,12 @@ private:
 	UPROPERTY()
 	class AAIController* EnemyController;
 
+	UPROPERTY()
+	class UEnemyPerceptionSubsystem* Perception;
+
+	UPROPERTY()
+	class UEnemyNavPathCache* NavPathCache;
+
 	UPROPERTY(EditAnywhere, Category = "Combat")
 	float MinWaitBeforeStaggerRecover = 0.5f;
 
@@ -175,6 +242,7 @@ private:
 	
 	FTimerHandle StaggerTimer;
 	FTimerHandle PatrolTimer;
+	FTimerHandle DeathCleanupTimer;
 
 	UPROPERTY(EditInstanceOnly, Category = "AI Navigation", BlueprintReadWrite, meta = (AllowPrivateAccess))
 	AActor* PatrolTarget;
@@ -182,6 +250,19 @@ private:
 	UPROPERTY(EditInstanceOnly, Category = "AI Navigation")
 	TArray<AActor*> PatrolTargets;
 
+	/** Baked paths between the PatrolTargets, shared with every enemy patrolling the same points */
+	TSharedPtr<const FPatrolRouteGraph> PatrolRoute;
+
+	/** Route point the enemy last arrived at and the one it is heading to, INDEX_NONE when off the route */
+	int32 PatrolPointIndex = INDEX_NONE;
+	int32 PatrolTargetIndex = INDEX_NONE;
+
+	/** Reused for every leg of the route so arriving at a point never allocates */
+	FNavPathSharedPtr PatrolPath;
+
+	/** True while PatrolTimer runs, the enemy just stands at the point */
+	bool bWaitingAtPatrolPoint = false;
+
 	UPROPERTY(EditAnywhere, Category = "AI Navigation")
 	float MinWaitBeforePatrol = 5.f;
 
@@ -193,6 +274,22 @@ private:
 
 	UPROPERTY(EditAnywhere, Category = "AI Navigation")
 	float ChasingSpeed = 300.f;
+
+	/** A MoveTo for the goal we are already walking to is dropped unless the goal moved further than this */
+	UPROPERTY(EditAnywhere, Category = "AI Navigation")
+	float RepathTolerance = 50.f;
+
+	TWeakObjectPtr<AActor> LastMoveGoal;
+	FVector LastMoveGoalLocation = FVector::ZeroVector;
+
+	/** Slot in UEnemyAIManager's arrays, INDEX_NONE while unregistered */
+	int32 AIManagerIndex = INDEX_NONE;
+
+	/** Group this enemy's pose is shared in, owned by UEnemyAnimSharingSubsystem */
+	EEnemyAnimShareState AnimShareState = EEnemyAnimShareState::None;
+
+	/** PawnSensing interval as authored, restored when the enemy is significant again */
+	float DefaultSensingInterval = 0.5f;
 public:
 	FORCEINLINE EEnemyState GetEnemyState() const { return EnemyState; }
 
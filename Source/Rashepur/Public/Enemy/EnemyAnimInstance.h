@@ -5,13 +5,15 @@
 #include "CoreMinimal.h"
 #include "Animation/AnimInstance.h"
 #include "CharacterStates.h"
+#include "Characters/BaseCharacter.h"
 
 #include "EnemyAnimInstance.generated.h"
 
 class UCharacterMovementComponent;
 class AEnemy;
 /**
- * 
+ * Copies the enemy's FCharacterAnimSnapshot on the game thread and fills the graph variables from it in
+ * NativeThreadSafeUpdateAnimation, so the update runs on a worker thread when multi threaded animation update is on.
  */
 UCLASS()
 class RASHEPUR_API UEnemyAnimInstance : public UAnimInstance
@@ -20,7 +22,9 @@ class RASHEPUR_API UEnemyAnimInstance : public UAnimInstance
 
 public:
 	virtual void NativeInitializeAnimation() override;
-	virtual void NativeUpdateAnimation(float DeltaTime);
+	virtual void NativeBeginPlay() override;
+	virtual void NativeUpdateAnimation(float DeltaTime) override;
+	virtual void NativeThreadSafeUpdateAnimation(float DeltaTime) override;
 
 	UPROPERTY(BlueprintReadOnly, Category = "AnimInstance")
 	AEnemy* Enemy;
@@ -37,4 +41,6 @@ public:
 	UPROPERTY(BlueprintReadOnly, Category = "Movement | Character State")
 	EEnemyState EnemyState;
 
+private:
+	FCharacterAnimSnapshot Snapshot;
 };
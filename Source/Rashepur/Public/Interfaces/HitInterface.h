@@ -24,4 +24,7 @@ class RASHEPUR_API IHitInterface
 public:
 	UFUNCTION(BlueprintNativeEvent)
 	void GetHit(const FVector& ImpactPoint, AActor* Hitter);
+
+	/** Execute_GetHit without ProcessEvent when Actor's class does not override GetHit in Blueprint, does nothing if it is not hittable */
+	static void DispatchGetHit(AActor* Actor, const FVector& ImpactPoint, AActor* Hitter);
 };
@@ -0,0 +1,35 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * How a class answers one BlueprintNativeEvent of an interface, resolved once per class and cached.
+ * Native classes that do not override the event in Blueprint are called through the C++ vtable at the cached
+ * interface offset, everything else still goes through Execute_ and ProcessEvent.
+ */
+namespace InterfaceDispatch
+{
+	enum class EDispatch : uint8
+	{
+		None,
+		Native,
+		Script
+	};
+
+	struct FResolved
+	{
+		EDispatch Dispatch = EDispatch::None;
+		/** Offset of the interface inside the object, only valid for Native */
+		int32 PointerOffset = 0;
+	};
+
+	RASHEPUR_API FResolved Resolve(const UObject* Object, const UClass* InterfaceClass, FName FunctionName);
+
+	template <typename InterfaceType>
+	FORCEINLINE InterfaceType* GetNative(UObject* Object, const FResolved& Resolved)
+	{
+		return reinterpret_cast<InterfaceType*>(reinterpret_cast<uint8*>(Object) + Resolved.PointerOffset);
+	}
+}
@@ -22,6 +22,13 @@ class RASHEPUR_API IPickupInterface
 
 	// Add interface functions to this class. This is the class that will be inherited to implement this interface.
 public:
-	virtual void SetOverlappingItem(class AItem* Item);
-	virtual void AddSouls(class ASoul* Soul);
+	UFUNCTION(BlueprintNativeEvent)
+	void SetOverlappingItem(class AItem* Item);
+
+	UFUNCTION(BlueprintNativeEvent)
+	void AddSouls(class ASoul* Soul);
+
+	/** Execute_ wrappers without ProcessEvent for native pickers, and without the interface Cast for actors that pick nothing up */
+	static void DispatchSetOverlappingItem(AActor* Actor, AItem* Item);
+	static void DispatchAddSouls(AActor* Actor, ASoul* Soul);
 };
@@ -0,0 +1,97 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "WorldCollision.h"
+#include "GameplayTraceScheduler.generated.h"
+
+/** Lower values are submitted first when the frame budget runs out */
+enum class EGameplayTracePriority : uint8
+{
+	/** Always submitted the frame it was requested, budget or not */
+	Critical,
+	High,
+	Normal,
+	Low
+};
+
+/** A line trace, or a sweep when Shape is not a line, of Channel from Start to End */
+struct RASHEPUR_API FGameplayTraceRequest
+{
+	FVector Start = FVector::ZeroVector;
+	FVector End = FVector::ZeroVector;
+	FQuat Rotation = FQuat::Identity;
+	FCollisionShape Shape;
+	ECollisionChannel Channel = ECollisionChannel::ECC_Visibility;
+	FCollisionQueryParams Params;
+	FCollisionResponseParams ResponseParams;
+	/** Every touch up to the first block instead of only the first block */
+	bool bMulti = false;
+
+	EGameplayTracePriority Priority = EGameplayTracePriority::Normal;
+	/** Frames the request may wait in the queue once the per frame budget is used up */
+	uint8 MaxDelayFrames = 2;
+};
+
+DECLARE_DELEGATE_OneParam(FOnGameplayTraceCompleted, const TArray<FHitResult>& /*Hits*/);
+
+/**
+ * Single entry point for gameplay traces. Queued requests are submitted once per frame as one batch of async physics queries,
+ * ordered by priority and limited to MaxTracesPerFrame, and their callbacks run the next frame when the results land.
+ * Traces whose result is needed right away, weapon hits for example, go through TraceNow, which runs synchronously
+ * but is counted alongside the batch so stat Rashepur shows every gameplay query.
+ */
+UCLASS(Config = Game)
+class RASHEPUR_API UGameplayTraceScheduler : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** <UTickableWorldSubsystem> */
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	/** </UTickableWorldSubsystem> */
+
+	/** Queues Request, OnCompleted runs when the async result arrives, usually the frame after submission */
+	void RequestTrace(const FGameplayTraceRequest& Request, FOnGameplayTraceCompleted OnCompleted);
+
+	/** Same frame trace for frame critical queries, returns whether anything blocking was hit */
+	bool TraceNow(const FGameplayTraceRequest& Request, TArray<FHitResult>& OutHits) const;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FQueuedTrace
+	{
+		FGameplayTraceRequest Request;
+		FOnGameplayTraceCompleted OnCompleted;
+		uint64 RequestFrame = 0;
+	};
+
+	struct FInFlightTrace
+	{
+		FOnGameplayTraceCompleted OnCompleted;
+		uint64 RequestFrame = 0;
+	};
+
+	void SubmitBatch();
+	void Submit(FQueuedTrace& Queued);
+	void OnTraceCompleted(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum);
+
+	TArray<FQueuedTrace> Queue;
+	/** Requests that did not fit this frame, swapped with Queue so neither array reallocates */
+	TArray<FQueuedTrace> Deferred;
+	/** Indexed by the async trace's UserData */
+	TSparseArray<FInFlightTrace> InFlight;
+	FTraceDelegate TraceDelegate;
+	uint32 MaxLatency = 0;
+
+	/** Queued traces submitted per frame before non critical ones start waiting */
+	UPROPERTY(Config)
+	int32 MaxTracesPerFrame = 128;
+};
@@ -0,0 +1,140 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Rashepur.h"
+#include "SpatialHashSubsystem.generated.h"
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Spatial Hash Query"), STAT_SpatialHashQuery, STATGROUP_Rashepur, RASHEPUR_API);
+
+/** What kind of actor an entry is, queries filter with a mask of these */
+namespace ESpatialCategory
+{
+	constexpr uint8 Enemy = 1 << 0;
+	constexpr uint8 Hero = 1 << 1;
+	constexpr uint8 Pickup = 1 << 2;
+	constexpr uint8 Breakable = 1 << 3;
+	constexpr uint8 All = 0xFF;
+}
+
+/**
+ * Uniform grid of world space cells holding the pawns, pickups and breakables of the level.
+ * Entries are updated from their root component's TransformUpdated event, so only actors that moved cost anything,
+ * and re-bucketed only when they cross a cell border. Queries visit the covered cells and hand every match
+ * to a callback, so they never allocate.
+ */
+UCLASS()
+class RASHEPUR_API USpatialHashSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** <UWorldSubsystem> */
+	virtual void Deinitialize() override;
+	/** </UWorldSubsystem> */
+
+	void Register(AActor* Actor, uint8 Category);
+	void Unregister(AActor* Actor);
+
+	/** Calls Visitor(AActor*, double DistSquared) for every registered actor of CategoryMask within Radius of Center */
+	template<typename VisitorType>
+	void ForEachInRadius(const FVector& Center, double Radius, uint8 CategoryMask, VisitorType&& Visitor) const;
+
+	/** Same as ForEachInRadius, limited to the cone around Direction (unit vector) with half angle acos(CosHalfAngle) */
+	template<typename VisitorType>
+	void ForEachInCone(const FVector& Origin, const FVector& Direction, double Radius, double CosHalfAngle, uint8 CategoryMask, VisitorType&& Visitor) const;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FEntry
+	{
+		TWeakObjectPtr<AActor> Actor;
+		TObjectKey<AActor> Key;
+		FVector Location;
+		FIntVector Cell;
+		uint8 Category = 0;
+	};
+
+	using FCellEntries = TArray<int32, TInlineAllocator<8>>;
+
+	template<typename EntryVisitorType>
+	void ForEachEntryInRadius(const FVector& Center, double Radius, uint8 CategoryMask, EntryVisitorType&& EntryVisitor) const;
+
+	FIntVector ToCell(const FVector& Location) const;
+	void AddToCell(const FIntVector& Cell, int32 EntryIndex);
+	void RemoveFromCell(const FIntVector& Cell, int32 EntryIndex);
+	void RemoveEntry(int32 EntryIndex);
+	UFUNCTION()
+	void OnActorEndPlay(AActor* Actor, EEndPlayReason::Type EndPlayReason);
+
+	void OnTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport);
+	void RecordQuery(int32 CellsVisited, int32 EntriesTested) const;
+
+	/** Roughly the CombatRadius, so a combat query touches a handful of cells */
+	double CellSize = 1000.0;
+
+	TArray<FEntry> Entries;
+	TMap<TObjectKey<AActor>, int32> EntryIndices;
+	TMap<FIntVector, FCellEntries> Cells;
+};
+
+template<typename EntryVisitorType>
+void USpatialHashSubsystem::ForEachEntryInRadius(const FVector& Center, double Radius, uint8 CategoryMask, EntryVisitorType&& EntryVisitor) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_SpatialHashQuery);
+
+	const FIntVector MinCell = ToCell(Center - FVector(Radius));
+	const FIntVector MaxCell = ToCell(Center + FVector(Radius));
+	const double RadiusSquared = Radius * Radius;
+	int32 CellsVisited = 0;
+	int32 EntriesTested = 0;
+
+	for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+	for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+	for (int32 Z = MinCell.Z; Z <= MaxCell.Z; ++Z)
+	{
+		const FCellEntries* Cell = Cells.Find(FIntVector(X, Y, Z));
+		if (Cell == nullptr) continue;
+		++CellsVisited;
+
+		for (int32 EntryIndex : *Cell)
+		{
+			const FEntry& Entry = Entries[EntryIndex];
+			if (!(Entry.Category & CategoryMask)) continue;
+			++EntriesTested;
+
+			const double DistSquared = FVector::DistSquared(Entry.Location, Center);
+			if (DistSquared <= RadiusSquared)
+				EntryVisitor(Entry, DistSquared);
+		}
+	}
+	RecordQuery(CellsVisited, EntriesTested);
+}
+
+template<typename VisitorType>
+void USpatialHashSubsystem::ForEachInRadius(const FVector& Center, double Radius, uint8 CategoryMask, VisitorType&& Visitor) const
+{
+	ForEachEntryInRadius(Center, Radius, CategoryMask, [&Visitor](const FEntry& Entry, double DistSquared)
+	{
+		if (AActor* Actor = Entry.Actor.Get())
+			Visitor(Actor, DistSquared);
+	});
+}
+
+template<typename VisitorType>
+void USpatialHashSubsystem::ForEachInCone(const FVector& Origin, const FVector& Direction, double Radius, double CosHalfAngle, uint8 CategoryMask, VisitorType&& Visitor) const
+{
+	ForEachEntryInRadius(Origin, Radius, CategoryMask, [&Origin, &Direction, CosHalfAngle, &Visitor](const FEntry& Entry, double DistSquared)
+	{
+		const double Dot = FVector::DotProduct(Entry.Location - Origin, Direction);
+		if (Dot >= CosHalfAngle * FMath::Sqrt(DistSquared))
+		{
+			if (AActor* Actor = Entry.Actor.Get())
+				Visitor(Actor, DistSquared);
+		}
+	});
+}
@@ -3,3 +3,5 @@
 #pragma once
 
 #include "CoreMinimal.h"
+
+DECLARE_STATS_GROUP(TEXT("Rashepur"), STATGROUP_Rashepur, STATCAT_Advanced);
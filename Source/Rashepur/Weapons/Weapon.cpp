@@ -4,11 +4,11 @@
 #include "Weapon.h"
 #include "Rashepur/Characters/HeroCharacter.h"
 #include "Kismet/GameplayStatics.h"
-#include "Kismet/KismetSystemLibrary.h"
 #include "Components/SphereComponent.h"
 #include "Components/BoxComponent.h"
-#include "Interfaces/HitInterface.h"
+#include "WeaponHitbox.h"
 #include "NiagaraComponent.h"
+#include "Spatial/SpatialHashSubsystem.h"
 
 
 AWeapon::AWeapon()
@@ -30,6 +30,7 @@ AWeapon::AWeapon()
 
 void AWeapon::DisableWeaponCollision()
 {
+    Swing.End();
     if (WeaponBox)
     {
         WeaponBox->SetCollisionEnabled(ECollisionEnabled::NoCollision);
@@ -38,6 +39,18 @@ void AWeapon::DisableWeaponCollision()
 }
 void AWeapon::EnableWeaponCollision()
 {
+    SwingId = WeaponHitbox::NewSwingId();
+    if (bUseSwingTracking)
+    {
+        // the box stays off, Tick sweeps the blade until DisableWeaponCollision
+        Swing.MaxStepDistance = SwingMaxStepDistance;
+        Swing.MaxSubSteps = SwingMaxSubSteps;
+        Swing.bShowDebug = bShowBoxDebug;
+        Swing.Begin(GetBladeStart(), BoxTraceEnd->GetComponentLocation());
+        SwingHitActors.Reset();
+        TickSwing();
+        return;
+    }
     if (WeaponBox)
     {
         WeaponBox->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
@@ -49,9 +62,14 @@ void AWeapon::EnableWeaponCollision()
 void AWeapon::Equip(USceneComponent* InParent, FName InSocketName, AActor* NewOwner, APawn* NewInstigator)
 {    
     ItemState = EItemState::EIS_Equipped;
+    // held weapons follow the hand every frame and are nobody's pickup
+    if (USpatialHashSubsystem* SpatialHash = GetWorld()->GetSubsystem<USpatialHashSubsystem>())
+        SpatialHash->Unregister(this);
     SetOwner(NewOwner);
     SetInstigator(NewInstigator);
     AttachMeshSocket(InParent, InSocketName);
+    // swing tracking samples the blade after the hand has been animated this frame
+    AddTickPrerequisiteComponent(InParent);
     PlayEquipSound();
     DisableSphereCollision();
     DeactivateEmbers();
@@ -91,6 +109,30 @@ void AWeapon::AttachMeshSocket(USceneComponent *InParent, const FName &InSocketN
 void AWeapon::Tick(float DeltaTime)
 {
     Super::Tick(DeltaTime);
+    if (Swing.IsActive())
+        TickSwing();
+}
+
+FTransform AWeapon::GetBladeStart() const
+{
+    return BoxTraceStart->GetComponentTransform();
+}
+
+void AWeapon::TickSwing()
+{
+    FCollisionQueryParams Params(SCENE_QUERY_STAT(WeaponSwing), false, GetOwner());
+    Params.AddIgnoredActor(this);
+
+    SwingHits.Reset();
+    Swing.Advance(GetWorld(), Params, GetBladeStart(), BoxTraceEnd->GetComponentLocation(), BoxTraceExtent, SwingHitActors, SwingHits);
+
+    for (const FHitResult& Hit : SwingHits)
+    {
+        if (ActorIsSameType(Hit.GetActor())) continue;
+
+        WeaponHitbox::ApplyHit(Hit, Damage, GetInstigator()->GetController(), this, GetOwner(), SwingId,
+            FOnHitResolved::CreateUObject(this, &AWeapon::OnHitResolved));
+    }
 }
 
 void AWeapon::BeginPlay()
@@ -122,55 +164,26 @@ void AWeapon::OnBoxOverlap(UPrimitiveComponent* OverlappedComponent, AActor* Oth
     {
         if (ActorIsSameType(BoxHit.GetActor())) return;
 
-        UGameplayStatics::ApplyDamage(BoxHit.GetActor(), Damage, GetInstigator()->GetController(), this, UDamageType::StaticClass());
-        ExecuteGetHit(BoxHit);
-        CreateFields(BoxHit.ImpactPoint);
+        WeaponHitbox::ApplyHit(BoxHit, Damage, GetInstigator()->GetController(), this, GetOwner(), SwingId,
+            FOnHitResolved::CreateUObject(this, &AWeapon::OnHitResolved));
     }
 }
 
-bool AWeapon::ActorIsSameType(AActor* OtherActor)
+void AWeapon::OnHitResolved(const FHitResult& Hit)
 {
-    return GetOwner()->ActorHasTag(TEXT("Enemy")) && OtherActor->ActorHasTag(TEXT("Enemy"));
+    CreateFields(Hit.ImpactPoint);
 }
 
-void AWeapon::ExecuteGetHit(FHitResult& BoxHit)
+bool AWeapon::ActorIsSameType(AActor* OtherActor)
 {
-    IHitInterface* HitInterface = Cast<IHitInterface>(BoxHit.GetActor());
-    if (HitInterface)
-    {
-        AActor* Hitter = GetOwner();
-        HitInterface->Execute_GetHit(BoxHit.GetActor(), BoxHit.ImpactPoint, Hitter);
-    }
+    return !WeaponHitbox::CanHit(GetOwner(), OtherActor);
 }
 
 void AWeapon::BoxTrace(FHitResult& BoxHit)
 {
     const FVector Start = BoxTraceStart->GetComponentLocation();
     const FVector End = BoxTraceEnd->GetComponentLocation();
-
-    TArray<AActor*> ActorsToIgnore;
-    ActorsToIgnore.Add(GetOwner());
-
-    for (AActor* Actor : IgnoreActors)
-    {
-        ActorsToIgnore.AddUnique(Actor);
-    }
-
-    UKismetSystemLibrary::BoxTraceSingle(
-        this,
-        Start,
-        End,
-        BoxTraceExtent,
-        BoxTraceStart->GetComponentRotation(),
-        ETraceTypeQuery::TraceTypeQuery1,
-        false,
-        ActorsToIgnore,
-        bShowBoxDebug ? EDrawDebugTrace::ForDuration : EDrawDebugTrace::None,
-        BoxHit,
-        true
-    );
-    IgnoreActors.AddUnique(BoxHit.GetActor());
-
+    WeaponHitbox::BoxTrace(GetOwner(), Start, End, BoxTraceExtent, BoxTraceStart->GetComponentRotation(), IgnoreActors, bShowBoxDebug, BoxHit);
 }
 
 
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "WeaponTypes.h"
+#include "WeaponHitbox.h"
 #include "Rashepur/Item.h"
 #include "Weapon.generated.h"
 
@@ -42,14 +43,15 @@ protected:
 
     bool ActorIsSameType(AActor* OtherActor);
 
-    void ExecuteGetHit(FHitResult& BoxHit);
-
     UFUNCTION(BlueprintImplementableEvent)
     void CreateFields(const FVector& FieldLocation);
 
 private:
 
     void BoxTrace(FHitResult& BoxHit);
+    void TickSwing();
+    void OnHitResolved(const FHitResult& Hit);
+    FTransform GetBladeStart() const;
 
     UPROPERTY(EditAnywhere, Category = "Weapon Properties")
     FVector BoxTraceExtent = FVector(8.f);
@@ -57,6 +59,22 @@ private:
     UPROPERTY(EditAnywhere, Category = "Weapon Properties")
     bool bShowBoxDebug = false;
 
+    /** Sweep the blade every frame of the attack window instead of tracing once when the box starts overlapping */
+    UPROPERTY(EditAnywhere, Category = "Weapon Properties")
+    bool bUseSwingTracking = true;
+
+    /** Longest distance the blade moves per sweep while swing tracking, lower catches thinner targets at high AttackAnimationSpeed */
+    UPROPERTY(EditAnywhere, Category = "Weapon Properties", meta = (EditCondition = "bUseSwingTracking"))
+    float SwingMaxStepDistance = 20.f;
+
+    UPROPERTY(EditAnywhere, Category = "Weapon Properties", meta = (EditCondition = "bUseSwingTracking"))
+    int32 SwingMaxSubSteps = 8;
+
+    FWeaponSwing Swing;
+    TSet<TObjectKey<AActor>> SwingHitActors;
+    TArray<FHitResult> SwingHits;
+    uint32 SwingId = 0;
+
     UPROPERTY(EditAnywhere, Category = "Weapon Properties")
     USoundBase* EquipSound;
 
@@ -87,5 +105,14 @@ public:
 	FORCEINLINE USoundBase* GetUnequipWeaponSound() const { return UnequipSound; }
 
     FORCEINLINE UBoxComponent* GetWeaponBox() const { return WeaponBox; }
+    FORCEINLINE USceneComponent* GetBoxTraceStart() const { return BoxTraceStart; }
+    FORCEINLINE USceneComponent* GetBoxTraceEnd() const { return BoxTraceEnd; }
+    FORCEINLINE UStaticMeshComponent* GetItemMesh() const { return ItemMesh; }
+    FORCEINLINE const FVector& GetBoxTraceExtent() const { return BoxTraceExtent; }
+    FORCEINLINE bool ShowsBoxDebug() const { return bShowBoxDebug; }
+    FORCEINLINE float GetDamage() const { return Damage; }
+    FORCEINLINE bool UsesSwingTracking() const { return bUseSwingTracking; }
+    FORCEINLINE float GetSwingMaxStepDistance() const { return SwingMaxStepDistance; }
+    FORCEINLINE int32 GetSwingMaxSubSteps() const { return SwingMaxSubSteps; }
     FORCEINLINE EWeaponType GetWeaponType() const { return WeaponType; }
 };
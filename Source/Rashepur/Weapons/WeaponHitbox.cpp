@@ -0,0 +1,224 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "WeaponHitbox.h"
+#include "Rashepur.h"
+#include "Engine/World.h"
+#include "DrawDebugHelpers.h"
+#include "Kismet/GameplayStatics.h"
+#include "Spatial/GameplayTraceScheduler.h"
+#include "Spatial/SpatialHashSubsystem.h"
+#include "HAL/IConsoleManager.h"
+#include "Interfaces/HitInterface.h"
+#include "Components/CombatStatusComponent.h"
+
+DECLARE_CYCLE_STAT(TEXT("Weapon Swing Sweep"), STAT_WeaponSwingSweep, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Weapon Swing Sweeps"), STAT_WeaponSwingSweeps, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Weapon Swing Sweeps Skipped"), STAT_WeaponSwingSweepsSkipped, STATGROUP_Rashepur);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Weapon Swing Hits"), STAT_WeaponSwingHits, STATGROUP_Rashepur);
+
+static TAutoConsoleVariable<bool> CVarLogSwingSweeps(
+	TEXT("Rashepur.Combat.LogSwingSweeps"),
+	false,
+	TEXT("Logs how many sweeps every weapon swing ran and how many the spatial hash broadphase skipped"));
+
+namespace WeaponHitbox
+{
+	/** Same frame trace through the scheduler so it shows in its stats, straight to the world where there is none (editor previews) */
+	static void TraceNow(const UWorld* World, const FGameplayTraceRequest& Request, TArray<FHitResult>& OutHits)
+	{
+		if (const UGameplayTraceScheduler* Scheduler = World->GetSubsystem<UGameplayTraceScheduler>())
+		{
+			Scheduler->TraceNow(Request, OutHits);
+			return;
+		}
+
+		if (Request.bMulti)
+		{
+			World->SweepMultiByChannel(OutHits, Request.Start, Request.End, Request.Rotation, Request.Channel, Request.Shape, Request.Params, Request.ResponseParams);
+			return;
+		}
+		FHitResult Hit;
+		if (World->SweepSingleByChannel(Hit, Request.Start, Request.End, Request.Rotation, Request.Channel, Request.Shape, Request.Params, Request.ResponseParams))
+			OutHits.Add(Hit);
+	}
+}
+
+bool WeaponHitbox::CanHit(const AActor* Owner, const AActor* OtherActor)
+{
+	return UCombatStatusComponent::CanDamage(Owner, OtherActor);
+}
+
+bool WeaponHitbox::BoxTrace(AActor* Owner, const FVector& Start, const FVector& End, const FVector& Extent, const FRotator& Orientation,
+	TArray<AActor*>& IgnoreActors, bool bShowDebug, FHitResult& OutHit)
+{
+	UWorld* World = Owner ? Owner->GetWorld() : nullptr;
+	if (World == nullptr) return false;
+
+	// a hit has to land on the frame of the swing, so this skips the batch
+	FGameplayTraceRequest Request;
+	Request.Start = Start;
+	Request.End = End;
+	Request.Rotation = Orientation.Quaternion();
+	Request.Shape = FCollisionShape::MakeBox(Extent);
+	Request.Channel = ECollisionChannel::ECC_Visibility;
+	Request.Params = FCollisionQueryParams(SCENE_QUERY_STAT(WeaponBoxTrace), false, Owner);
+	Request.Params.AddIgnoredActors(IgnoreActors);
+	Request.Priority = EGameplayTracePriority::Critical;
+
+	TArray<FHitResult> Hits;
+	TraceNow(World, Request, Hits);
+	if (bShowDebug)
+		DrawDebugBox(World, End, Extent, Request.Rotation, Hits.Num() > 0 ? FColor::Red : FColor::Green, false, 5.f);
+
+	OutHit = Hits.Num() > 0 ? Hits[0] : FHitResult();
+	IgnoreActors.AddUnique(OutHit.GetActor());
+	return OutHit.GetActor() != nullptr;
+}
+
+uint32 WeaponHitbox::NewSwingId()
+{
+	return static_cast<uint32>(GFrameCounter);
+}
+
+void WeaponHitbox::ApplyHit(const FHitResult& Hit, float Damage, AController* EventInstigator, AActor* DamageCauser, AActor* Hitter,
+	uint32 SwingId, FOnHitResolved OnResolved)
+{
+	AActor* HitActor = Hit.GetActor();
+	if (HitActor == nullptr) return;
+
+	if (UDamageResolutionSubsystem* DamageResolution = HitActor->GetWorld()->GetSubsystem<UDamageResolutionSubsystem>())
+	{
+		DamageResolution->QueueHit(Hit, Damage, EventInstigator, DamageCauser, Hitter, SwingId, MoveTemp(OnResolved));
+		return;
+	}
+
+	UGameplayStatics::ApplyDamage(HitActor, Damage, EventInstigator, DamageCauser, UDamageType::StaticClass());
+
+	IHitInterface::DispatchGetHit(HitActor, Hit.ImpactPoint, Hitter);
+	OnResolved.ExecuteIfBound(Hit);
+}
+
+void FWeaponSwing::Begin(const FTransform& BladeStart, const FVector& BladeEnd)
+{
+	LastBladeStart = BladeStart;
+	LastBladeEnd = BladeEnd;
+	bActive = true;
+	NumSwingFrames = 0;
+	NumSwingSweeps = 0;
+	NumSwingSweepsSkipped = 0;
+}
+
+void FWeaponSwing::End()
+{
+	if (bActive && CVarLogSwingSweeps.GetValueOnGameThread())
+	{
+		UE_LOG(LogTemp, Display, TEXT("Weapon swing: %d frames, %d sweeps, %d more skipped by the broadphase"),
+			NumSwingFrames, NumSwingSweeps, NumSwingSweepsSkipped);
+	}
+	bActive = false;
+}
+
+bool FWeaponSwing::HasCandidates(const UWorld* World, const FCollisionQueryParams& Params, const FVector& StartFrom, const FVector& StartTo,
+	const FVector& BladeEnd, const FVector& Extent, const TSet<TObjectKey<AActor>>& HitActors) const
+{
+	const USpatialHashSubsystem* SpatialHash = World->GetSubsystem<USpatialHashSubsystem>();
+	if (SpatialHash == nullptr) return true;
+
+	// a sphere around everything the blade passes through this frame, entries are tracked by their origin so their reach is added on top
+	FBox SweptBounds(ForceInit);
+	SweptBounds += StartFrom;
+	SweptBounds += StartTo;
+	SweptBounds += LastBladeEnd;
+	SweptBounds += BladeEnd;
+	const double Radius = SweptBounds.GetExtent().Size() + Extent.GetMax() + BroadphaseMargin;
+
+	bool bHasCandidates = false;
+	const auto& IgnoredActors = Params.GetIgnoredActors();
+	SpatialHash->ForEachInRadius(SweptBounds.GetCenter(), Radius, ESpatialCategory::Enemy | ESpatialCategory::Hero | ESpatialCategory::Breakable,
+		[&bHasCandidates, &IgnoredActors, &HitActors](AActor* Actor, double DistSquared)
+		{
+			if (!bHasCandidates && !IgnoredActors.Contains(Actor->GetUniqueID()) && !HitActors.Contains(Actor))
+				bHasCandidates = true;
+		});
+	return bHasCandidates;
+}
+
+void FWeaponSwing::Advance(const UWorld* World, const FCollisionQueryParams& Params, const FTransform& BladeStart, const FVector& BladeEnd,
+	const FVector& Extent, TSet<TObjectKey<AActor>>& HitActors, TArray<FHitResult>& OutNewHits)
+{
+	if (!bActive || World == nullptr) return;
+	SCOPE_CYCLE_COUNTER(STAT_WeaponSwingSweep);
+
+	const FVector StartFrom = LastBladeStart.GetLocation();
+	const FVector StartTo = BladeStart.GetLocation();
+	const double Travel = FMath::Max(FVector::Dist(StartFrom, StartTo), FVector::Dist(LastBladeEnd, BladeEnd));
+	const int32 NumSteps = FMath::Clamp(FMath::CeilToInt32(Travel / FMath::Max(MaxStepDistance, 1.f)), 1, FMath::Max(MaxSubSteps, 1));
+	++NumSwingFrames;
+
+	// most swing frames cut through air, then none of the sub-steps can hit anything worth reporting
+	if (!HasCandidates(World, Params, StartFrom, StartTo, BladeEnd, Extent, HitActors))
+	{
+		NumSwingSweepsSkipped += NumSteps;
+		INC_DWORD_STAT_BY(STAT_WeaponSwingSweepsSkipped, NumSteps);
+		LastBladeStart = BladeStart;
+		LastBladeEnd = BladeEnd;
+		return;
+	}
+
+	// touches instead of blocks, otherwise the sweep stops at the first pawn; hits land on the frame of the swing
+	FGameplayTraceRequest Request;
+	Request.Channel = ECollisionChannel::ECC_Visibility;
+	Request.Params = Params;
+	Request.ResponseParams = FCollisionResponseParams(ECollisionResponse::ECR_Overlap);
+	Request.bMulti = true;
+	Request.Priority = EGameplayTracePriority::Critical;
+
+	FVector PreviousCenter = (StartFrom + LastBladeEnd) * 0.5;
+	for (int32 Step = 1; Step <= NumSteps; ++Step)
+	{
+		const float Alpha = (float)Step / NumSteps;
+		const FVector Start = FMath::Lerp(StartFrom, StartTo, Alpha);
+		const FVector End = FMath::Lerp(LastBladeEnd, BladeEnd, Alpha);
+		const FQuat Up = FQuat::Slerp(LastBladeStart.GetRotation(), BladeStart.GetRotation(), Alpha);
+
+		// the box covers the whole blade, its X axis along it
+		const FVector Blade = End - Start;
+		const double HalfLength = Blade.Size() * 0.5;
+		const FQuat Orientation = HalfLength > UE_KINDA_SMALL_NUMBER ? FRotationMatrix::MakeFromXZ(Blade, Up.GetUpVector()).ToQuat() : Up;
+		const FVector HalfExtent(HalfLength + Extent.X, Extent.Y, Extent.Z);
+		const FVector Center = (Start + End) * 0.5;
+
+		Request.Start = PreviousCenter;
+		Request.End = Center;
+		Request.Rotation = Orientation;
+		Request.Shape = FCollisionShape::MakeBox(HalfExtent);
+		SweepHits.Reset();
+		WeaponHitbox::TraceNow(World, Request, SweepHits);
+		++NumSwingSweeps;
+		INC_DWORD_STAT(STAT_WeaponSwingSweeps);
+
+		for (const FHitResult& Hit : SweepHits)
+		{
+			AActor* HitActor = Hit.GetActor();
+			bool bAlreadyHit = false;
+			if (HitActor)
+				HitActors.Add(HitActor, &bAlreadyHit);
+			if (HitActor && !bAlreadyHit)
+			{
+				FHitResult& NewHit = OutNewHits.Add_GetRef(Hit);
+				// a target already inside the box has no real impact point, the blade center is close enough for effects
+				if (NewHit.bStartPenetrating)
+					NewHit.ImpactPoint = Center;
+				INC_DWORD_STAT(STAT_WeaponSwingHits);
+			}
+		}
+
+		if (bShowDebug)
+			DrawDebugBox(World, Center, HalfExtent, Orientation, SweepHits.Num() > 0 ? FColor::Red : FColor::Green, false, 2.f);
+		PreviousCenter = Center;
+	}
+
+	LastBladeStart = BladeStart;
+	LastBladeEnd = BladeEnd;
+}
@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
+#include "Combat/DamageResolutionSubsystem.h"
+
+struct FCollisionQueryParams;
+
+/** Hit detection and delivery shared by AWeapon and the weapons held by UWeaponLoadoutComponent */
+namespace WeaponHitbox
+{
+	/** Faction and invulnerability bit tests, cheap enough to run on every overlap before any trace */
+	RASHEPUR_API bool CanHit(const AActor* Owner, const AActor* OtherActor);
+
+	/** Box trace from Start to End ignoring Owner and IgnoreActors, the actor hit is added to IgnoreActors so a swing hits it once */
+	RASHEPUR_API bool BoxTrace(AActor* Owner, const FVector& Start, const FVector& End, const FVector& Extent, const FRotator& Orientation,
+		TArray<AActor*>& IgnoreActors, bool bShowDebug, FHitResult& OutHit);
+
+	/** Id of a swing starting this frame, both hands of a dual wield attack are enabled by the same notify and share it */
+	RASHEPUR_API uint32 NewSwingId();
+
+	/**
+	 * Queues ApplyDamage and IHitInterface::GetHit on the actor of Hit with the world's UDamageResolutionSubsystem, Hitter is the character swinging.
+	 * OnResolved runs once the victim reacted; hits of the same Hitter and SwingId on one victim resolve once.
+	 */
+	RASHEPUR_API void ApplyHit(const FHitResult& Hit, float Damage, AController* EventInstigator, AActor* DamageCauser, AActor* Hitter,
+		uint32 SwingId, FOnHitResolved OnResolved);
+}
+
+/**
+ * Follows a blade, the segment from BoxTraceStart to BoxTraceEnd, through one attack window.
+ * Every frame the blade shaped box is swept from last frame's pose to this one in sub-steps short enough that a fast swing
+ * cannot pass through a target between frames; each sub-step is one multi sweep that reports every actor it touches.
+ * Frames where the spatial hash has no pawn or breakable near the blade skip the sweeps altogether.
+ */
+struct RASHEPUR_API FWeaponSwing
+{
+	/** Starts tracking from the blade's current pose */
+	void Begin(const FTransform& BladeStart, const FVector& BladeEnd);
+	void End();
+	FORCEINLINE bool IsActive() const { return bActive; }
+
+	/**
+	 * Sweeps from the last pose to this one and appends hits on actors that are not in HitActors yet, adding them.
+	 * HitActors belongs to the caller so both hands of a dual wield swing can share it.
+	 */
+	void Advance(const UWorld* World, const FCollisionQueryParams& Params, const FTransform& BladeStart, const FVector& BladeEnd,
+		const FVector& Extent, TSet<TObjectKey<AActor>>& HitActors, TArray<FHitResult>& OutNewHits);
+
+	/** Longest distance any end of the blade moves in one sub-step */
+	float MaxStepDistance = 20.f;
+	int32 MaxSubSteps = 8;
+	/** How far past its origin a pawn or breakable can be touched, the spatial hash only knows actor locations */
+	float BroadphaseMargin = 150.f;
+	bool bShowDebug = false;
+
+private:
+	/** Whether any pawn or breakable not ignored or already hit is near this frame's blade motion, always true without the spatial hash */
+	bool HasCandidates(const UWorld* World, const FCollisionQueryParams& Params, const FVector& StartFrom, const FVector& StartTo,
+		const FVector& BladeEnd, const FVector& Extent, const TSet<TObjectKey<AActor>>& HitActors) const;
+
+	FTransform LastBladeStart;
+	FVector LastBladeEnd = FVector::ZeroVector;
+	bool bActive = false;
+
+	/** Counted from Begin, logged by End with Rashepur.Combat.LogSwingSweeps */
+	int32 NumSwingFrames = 0;
+	int32 NumSwingSweeps = 0;
+	int32 NumSwingSweepsSkipped = 0;
+
+	/** Reused by every sweep so tracking a swing does not allocate */
+	TArray<FHitResult> SweepHits;
+};